@@ -34,7 +34,7 @@ boost::regex AdcCommandApi::commandReg(R"([A-Z][A-Z0-9]{2})");
 boost::regex AdcCommandApi::supportReg(R"([A-Z][A-Z0-9]{3})");
 
 #define SUPPORT_PARAM_ID "support"
-#define SUPPORT_PARAM (ApiModule::RequestHandler::Param(SUPPORT_PARAM_ID, regex(R"([A-Z][A-Z0-9]{3})")))
+#define SUPPORT_PARAM CUSTOM_PARAM(SUPPORT_PARAM_ID, AdcCommandApi::isSupportToken)
 
 #define HOOK_OUTGOING_HUB_COMMAND "outgoing_hub_command_hook"
 #define HOOK_OUTGOING_UDP_COMMAND "outgoing_udp_command_hook"
@@ -285,13 +285,13 @@ boost::regex AdcCommandApi::supportReg(R"([A-Z][A-Z0-9]{3})");
 		return CODE_DEFERRED;
 	}
 	api_return AdcCommandApi::SupportHandler::handleAddSupport(ApiRequest& aRequest) {
-		const auto& support = aRequest.getStringParam(SUPPORT_PARAM_ID);
+		const auto support = string(aRequest.getStringParam(SUPPORT_PARAM_ID));
 		auto success = supportStore.add(support);
 		return http::status::no_content;
 	}
 
 	api_return AdcCommandApi::SupportHandler::handleRemoveSupport(ApiRequest& aRequest) {
-		const auto& support = aRequest.getStringParam(SUPPORT_PARAM_ID);
+		const auto support = string(aRequest.getStringParam(SUPPORT_PARAM_ID));
 		auto success = supportStore.remove(support);
 		if (!success) {
 			aRequest.setResponseErrorStr("Support " + support + " was not found");
@@ -380,9 +380,13 @@ boost::regex AdcCommandApi::supportReg(R"([A-Z][A-Z0-9]{3})");
 		});
 	}
 
+	bool AdcCommandApi::isSupportToken(std::string_view aToken) noexcept {
+		return boost::regex_match(aToken.begin(), aToken.end(), supportReg);
+	}
+
 	string AdcCommandApi::deserializeSupportString(const json& aCmd, const string& aFieldName) {
 		auto support = JsonUtil::parseValue<string>(aFieldName, aCmd, false);
-		if (!boost::regex_match(support, supportReg)) {
+		if (!isSupportToken(support)) {
 			JsonUtil::throwError(aFieldName, JsonException::ERROR_INVALID, "Invalid support " + support);
 		}
 
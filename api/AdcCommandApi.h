@@ -50,6 +50,7 @@ namespace webserver {
 		static json serializeUserConnection(const UserConnection& aUserConnection) noexcept;
 
 		static string deserializeSupportString(const json& aCmd, const string& aFieldName);
+		static bool isSupportToken(std::string_view aToken) noexcept;
 		static AdcCommand::CommandType deserializeCommandField(const json& aCmd, const string& aFieldName);
 
 		static AdcCommand::CommandType parseCommand(const string& aCommandStr);
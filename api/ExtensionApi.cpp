@@ -32,7 +32,7 @@
 
 
 #define EXTENSION_PARAM_ID "extension"
-#define EXTENSION_PARAM (ApiModule::RequestHandler::Param(EXTENSION_PARAM_ID, regex(R"(^airdcpp-.+$)")))
+#define EXTENSION_PARAM CUSTOM_PARAM(EXTENSION_PARAM_ID, ExtensionApi::isExtensionNameToken)
 namespace webserver {
 	StringList ExtensionApi::subscriptionList = {
 		"extension_added",
@@ -42,6 +42,10 @@ namespace webserver {
 		"extension_installation_failed",
 	};
 
+	bool ExtensionApi::isExtensionNameToken(std::string_view aToken) noexcept {
+		return aToken.size() > 8 && aToken.starts_with("airdcpp-");
+	}
+
 	ExtensionApi::ExtensionApi(Session* aSession) : 
 		ParentApiModule(EXTENSION_PARAM, Access::SETTINGS_VIEW, aSession,
 			[](const string& aId) { return aId; },
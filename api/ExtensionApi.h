@@ -34,6 +34,9 @@ namespace webserver {
 		~ExtensionApi();
 
 		static StringList subscriptionList;
+
+		// Extension names are prefixed with "airdcpp-"
+		static bool isExtensionNameToken(std::string_view aToken) noexcept;
 	private:
 		void addExtension(const ExtensionPtr& aExtension) noexcept;
 
@@ -52,8 +52,7 @@ namespace webserver {
 	}
 
 	api_return FavoriteHubApi::handleGetHubs(ApiRequest& aRequest) {
-		auto j = Serializer::serializeItemList(aRequest.getRangeParam(START_POS), aRequest.getRangeParam(MAX_COUNT), FavoriteHubUtils::propertyHandler, getEntryList());
-		aRequest.setResponseBody(j);
+		aRequest.setResponseBodyRaw(Serializer::writeItemList(aRequest.getRangeParam(START_POS), aRequest.getRangeParam(MAX_COUNT), FavoriteHubUtils::propertyHandler, getEntryList()));
 
 		return http::status::ok;
 	}
@@ -199,7 +198,7 @@ namespace webserver {
 		});
 	}
 	void FavoriteHubApi::on(FavoriteManagerListener::FavoriteHubUpdated, const FavoriteHubEntryPtr& e) noexcept {
-		view.onItemUpdated(e, toPropertyIdSet(FavoriteHubUtils::properties));
+		view.onItemUpdated(e, FavoriteHubUtils::propertyHandler.allProperties);
 
 		maybeSend("favorite_hub_updated", [&] {
 			return Serializer::serializeItem(e, FavoriteHubUtils::propertyHandler);
@@ -46,7 +46,7 @@ namespace webserver {
 		METHOD_HANDLER(Access::FILELISTS_VIEW,	METHOD_POST,	(EXACT_PARAM("directory")),									FilelistInfo::handleChangeDirectory);
 		METHOD_HANDLER(Access::FILELISTS_VIEW,	METHOD_POST,	(EXACT_PARAM("read")),										FilelistInfo::handleSetRead);
 
-		METHOD_HANDLER(Access::FILELISTS_VIEW,	METHOD_GET,		(EXACT_PARAM("items"), RANGE_START_PARAM, RANGE_MAX_PARAM), FilelistInfo::handleGetItems);
+		METHOD_HANDLER_COST(Access::FILELISTS_VIEW,	METHOD_GET,	(EXACT_PARAM("items"), RANGE_START_PARAM, RANGE_MAX_PARAM), FilelistInfo::handleGetItems, 2);
 		METHOD_HANDLER(Access::FILELISTS_VIEW,	METHOD_GET,		(EXACT_PARAM("items"), TOKEN_PARAM),						FilelistInfo::handleGetItem);
 	}
 
@@ -95,14 +95,20 @@ namespace webserver {
 		int start = aRequest.getRangeParam(START_POS);
 		int count = aRequest.getRangeParam(MAX_COUNT);
 
+		string output;
 		{
 			auto curDir = ensureCurrentDirectoryLoaded();
-			aRequest.setResponseBody({
-				{ "list_path", curDir->getAdcPathUnsafe() },
-				{ "items", Serializer::serializeItemList(start, count, FilelistUtils::propertyHandler, currentViewItems) },
-			});
+
+			JsonWriter writer(output);
+			writer.startObject();
+			writer.key("items");
+			Serializer::writeItemList(start, count, FilelistUtils::propertyHandler, currentViewItems, writer);
+			writer.field("list_path", curDir->getAdcPathUnsafe());
+			writer.endObject();
 		}
 
+		aRequest.setResponseBodyRaw(std::move(output));
+
 		return http::status::ok;
 	}
 
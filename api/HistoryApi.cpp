@@ -73,7 +73,7 @@ namespace webserver {
 		}
 
 		dcassert(0);
-		throw RequestException(http::status::bad_request, "Invalid entry history type " + name);
+		throw RequestException(http::status::bad_request, "Invalid entry history type " + string(name));
 	}
 
 	SettingsManager::HistoryType HistoryApi::toHistoryType(ApiRequest& aRequest) {
@@ -87,7 +87,7 @@ namespace webserver {
 		}
 
 		dcassert(0);
-		throw RequestException(http::status::bad_request, "Invalid string history type " + name);
+		throw RequestException(http::status::bad_request, "Invalid string history type " + string(name));
 	}
 
 	json HistoryApi::serializeRecentEntry(const RecentEntryPtr& aEntry) noexcept {
@@ -103,8 +103,7 @@ namespace webserver {
 		auto start = aRequest.getRangeParam(START_POS);
 		auto count = aRequest.getRangeParam(MAX_COUNT);
 
-		auto j = Serializer::serializeItemList(start, count, OnlineUserUtils::propertyHandler, users);
-		aRequest.setResponseBody(j);
+		aRequest.setResponseBodyRaw(Serializer::writeItemList(start, count, OnlineUserUtils::propertyHandler, users));
 		return http::status::ok;
 	}
 
@@ -20,7 +20,10 @@
 
 #include <api/QueueApi.h>
 
+#include <web-server/EventBus.h>
 #include <web-server/JsonUtil.h>
+#include <web-server/Session.h>
+#include <web-server/WebServerManager.h>
 #include <web-server/WebServerSettings.h>
 
 #include <api/common/Serializer.h>
@@ -45,30 +48,11 @@ namespace webserver {
 	QueueApi::QueueApi(Session* aSession) : 
 		HookApiModule(aSession, Access::QUEUE_VIEW, Access::QUEUE_EDIT), 
 		bundleView("queue_bundle_view", this, QueueBundleUtils::propertyHandler, getBundleList), 
-		fileView("queue_file_view", this, QueueFileUtils::propertyHandler, getFileList) 
+		fileView("queue_file_view", this, QueueFileUtils::propertyHandler, getFileList),
+		eventPublisher(aSession->getServer()->getEventBus().getPublisher<QueueEventPublisher>())
 	{
-		createSubscriptions({
-			"queue_bundle_added",
-			"queue_bundle_removed",
-			"queue_bundle_updated",
-
-			// These are included in queue_bundle_updated events as well
-			"queue_bundle_tick",
-			"queue_bundle_content",
-			"queue_bundle_priority",
-			"queue_bundle_status",
-			"queue_bundle_sources",
-
-			"queue_file_added",
-			"queue_file_removed",
-			"queue_file_updated",
-
-			// These are included in queue_file_updated events as well
-			"queue_file_priority",
-			"queue_file_status",
-			"queue_file_sources",
-			"queue_file_tick",
-		});
+		// Events are serialized once for all sessions
+		createSharedSubscriptions(QueueEventPublisher::subscriptions);
 
 		// Hooks
 		HOOK_HANDLER(HOOK_FILE_FINISHED,	QueueManager::getInstance()->fileCompletionHook,	QueueApi::fileCompletionHook);
@@ -112,7 +96,7 @@ namespace webserver {
 		// METHOD_HANDLER(Access::QUEUE_EDIT,	METHOD_DELETE,	(EXACT_PARAM("files"), TOKEN_PARAM, EXACT_PARAM("segments")),														QueueApi::handleResetFileSegments);
 
 		METHOD_HANDLER(Access::QUEUE_EDIT,	METHOD_DELETE,	(EXACT_PARAM("sources"), CID_PARAM),									QueueApi::handleRemoveSource);
-		METHOD_HANDLER(Access::ANY,			METHOD_POST,	(EXACT_PARAM("find_dupe_paths")),										QueueApi::handleFindDupePaths);
+		METHOD_HANDLER_COST(Access::ANY,	METHOD_POST,	(EXACT_PARAM("find_dupe_paths")),										QueueApi::handleFindDupePaths, 5);
 		METHOD_HANDLER(Access::ANY,			METHOD_POST,	(EXACT_PARAM("check_path_queued")),										QueueApi::handleIsPathQueued);
 
 		// Listeners
@@ -280,9 +264,7 @@ namespace webserver {
 		int start = aRequest.getRangeParam(START_POS);
 		int count = aRequest.getRangeParam(MAX_COUNT);
 
-		auto j = Serializer::serializeItemList(start, count, QueueBundleUtils::propertyHandler, getBundleList());
-
-		aRequest.setResponseBody(j);
+		aRequest.setResponseBodyRaw(Serializer::writeItemList(start, count, QueueBundleUtils::propertyHandler, getBundleList()));
 		return http::status::ok;
 	}
 
@@ -350,9 +332,7 @@ namespace webserver {
 
 		int start = aRequest.getRangeParam(START_POS);
 		int count = aRequest.getRangeParam(MAX_COUNT);
-		auto j = Serializer::serializeItemList(start, count, QueueFileUtils::propertyHandler, files);
-
-		aRequest.setResponseBody(j);
+		aRequest.setResponseBodyRaw(Serializer::writeItemList(start, count, QueueFileUtils::propertyHandler, files));
 		return http::status::ok;
 	}
 
@@ -553,7 +533,7 @@ namespace webserver {
 		auto tth = aRequest.getTTHParam();
 
 		const auto files = QueueManager::getInstance()->findFiles(tth);
-		aRequest.setResponseBody(Serializer::serializeItemList(QueueFileUtils::propertyHandler, files));
+		aRequest.setResponseBodyRaw(Serializer::writeItemList(QueueFileUtils::propertyHandler, files));
 		return http::status::ok;
 	}
 
@@ -675,62 +655,29 @@ namespace webserver {
 	}
 
 
-	// FILE LISTENERS
+	// FILE LISTENERS (events are sent by QueueEventPublisher)
 	void QueueApi::on(QueueManagerListener::ItemAdded, const QueueItemPtr& aQI) noexcept {
 		fileView.onItemAdded(aQI);
-		if (!subscriptionActive("queue_file_added"))
-			return;
-
-		send("queue_file_added", Serializer::serializeItem(aQI, QueueFileUtils::propertyHandler));
 	}
 
 	void QueueApi::on(QueueManagerListener::ItemRemoved, const QueueItemPtr& aQI, bool /*finished*/) noexcept {
 		fileView.onItemRemoved(aQI);
-		if (!subscriptionActive("queue_file_removed"))
-			return;
-
-		send("queue_file_removed", Serializer::serializeItem(aQI, QueueFileUtils::propertyHandler));
-	}
-
-	void QueueApi::onFileUpdated(const QueueItemPtr& aQI, const PropertyIdSet& aUpdatedProperties, const string& aSubscription) {
-		fileView.onItemUpdated(aQI, aUpdatedProperties);
-		if (subscriptionActive(aSubscription)) {
-			// Serialize full item for more specific updates to make reading of data easier 
-			// (such as cases when the script is interested only in finished files)
-			send(aSubscription, Serializer::serializeItem(aQI, QueueFileUtils::propertyHandler));
-		}
-
-		if (subscriptionActive("queue_file_updated")) {
-			// Serialize updated properties only
-			// (but always include the bundle ID as well)
-			auto propertiesWithBundle = aUpdatedProperties;
-			propertiesWithBundle.insert(QueueFileUtils::PROP_BUNDLE);
-			send("queue_file_updated", Serializer::serializePartialItem(aQI, QueueFileUtils::propertyHandler, propertiesWithBundle));
-		}
 	}
 
 	void QueueApi::on(QueueManagerListener::ItemSources, const QueueItemPtr& aQI) noexcept {
-		onFileUpdated(aQI, { QueueFileUtils::PROP_SOURCES }, "queue_file_sources");
+		fileView.onItemUpdated(aQI, QueueEventPublisher::fileSourceProperties);
 	}
 
 	void QueueApi::on(QueueManagerListener::ItemStatus, const QueueItemPtr& aQI) noexcept {
-		onFileUpdated(aQI, { 
-			QueueFileUtils::PROP_STATUS, QueueFileUtils::PROP_TIME_FINISHED, QueueFileUtils::PROP_BYTES_DOWNLOADED, 
-			QueueFileUtils::PROP_SECONDS_LEFT, QueueFileUtils::PROP_SPEED 
-		}, "queue_file_status");
+		fileView.onItemUpdated(aQI, QueueEventPublisher::fileStatusProperties);
 	}
 
 	void QueueApi::on(QueueManagerListener::ItemPriority, const QueueItemPtr& aQI) noexcept {
-		onFileUpdated(aQI, {
-			QueueFileUtils::PROP_STATUS, QueueFileUtils::PROP_PRIORITY
-		}, "queue_file_priority");
+		fileView.onItemUpdated(aQI, QueueEventPublisher::filePriorityProperties);
 	}
 
 	void QueueApi::on(QueueManagerListener::ItemTick, const QueueItemPtr& aQI) noexcept {
-		onFileUpdated(aQI, {
-			QueueFileUtils::PROP_STATUS, QueueFileUtils::PROP_BYTES_DOWNLOADED,
-			QueueFileUtils::PROP_SECONDS_LEFT, QueueFileUtils::PROP_SPEED
-		}, "queue_file_tick");
+		fileView.onItemUpdated(aQI, QueueEventPublisher::fileTickProperties);
 	}
 
 	void QueueApi::on(QueueManagerListener::FileRecheckFailed, const QueueItemPtr&, const string&) noexcept {
@@ -738,61 +685,38 @@ namespace webserver {
 	}
 
 
-	// BUNDLE LISTENERS
+	// BUNDLE LISTENERS (events are sent by QueueEventPublisher)
 	void QueueApi::on(QueueManagerListener::BundleAdded, const BundlePtr& aBundle) noexcept {
 		bundleView.onItemAdded(aBundle);
-		if (!subscriptionActive("queue_bundle_added"))
-			return;
-
-		send("queue_bundle_added", Serializer::serializeItem(aBundle, QueueBundleUtils::propertyHandler));
 	}
+
 	void QueueApi::on(QueueManagerListener::BundleRemoved, const BundlePtr& aBundle) noexcept {
 		bundleView.onItemRemoved(aBundle);
-		if (!subscriptionActive("queue_bundle_removed"))
-			return;
-
-		send("queue_bundle_removed", Serializer::serializeItem(aBundle, QueueBundleUtils::propertyHandler));
-	}
-
-	void QueueApi::onBundleUpdated(const BundlePtr& aBundle, const PropertyIdSet& aUpdatedProperties, const string& aSubscription) {
-		bundleView.onItemUpdated(aBundle, aUpdatedProperties);
-		if (subscriptionActive(aSubscription)) {
-			// Serialize full item for more specific updates to make reading of data easier 
-			// (such as cases when the script is interested only in finished bundles)
-			send(aSubscription, Serializer::serializeItem(aBundle, QueueBundleUtils::propertyHandler));
-		}
-
-		if (subscriptionActive("queue_bundle_updated")) {
-			// Serialize updated properties only
-			send("queue_bundle_updated", Serializer::serializePartialItem(aBundle, QueueBundleUtils::propertyHandler, aUpdatedProperties));
-		}
 	}
 
 	void QueueApi::on(QueueManagerListener::BundleSize, const BundlePtr& aBundle) noexcept {
-		onBundleUpdated(aBundle, { QueueBundleUtils::PROP_SIZE, QueueBundleUtils::PROP_TYPE }, "queue_bundle_content");
+		bundleView.onItemUpdated(aBundle, QueueEventPublisher::bundleContentProperties);
 	}
 
 	void QueueApi::on(QueueManagerListener::BundlePriority, const BundlePtr& aBundle) noexcept {
-		onBundleUpdated(aBundle, { QueueBundleUtils::PROP_PRIORITY, QueueBundleUtils::PROP_STATUS }, "queue_bundle_priority");
+		bundleView.onItemUpdated(aBundle, QueueEventPublisher::bundlePriorityProperties);
 	}
 
 	void QueueApi::on(QueueManagerListener::BundleStatusChanged, const BundlePtr& aBundle) noexcept {
-		onBundleUpdated(aBundle, { QueueBundleUtils::PROP_STATUS, QueueBundleUtils::PROP_TIME_FINISHED }, "queue_bundle_status");
+		bundleView.onItemUpdated(aBundle, QueueEventPublisher::bundleStatusProperties);
 	}
 
 	void QueueApi::on(QueueManagerListener::BundleSources, const BundlePtr& aBundle) noexcept {
-		onBundleUpdated(aBundle, { QueueBundleUtils::PROP_SOURCES }, "queue_bundle_sources");
+		bundleView.onItemUpdated(aBundle, QueueEventPublisher::bundleSourceProperties);
 	}
 
-#define TICK_PROPS { QueueBundleUtils::PROP_SECONDS_LEFT, QueueBundleUtils::PROP_SPEED, QueueBundleUtils::PROP_STATUS, QueueBundleUtils::PROP_BYTES_DOWNLOADED }
 	void QueueApi::on(DownloadManagerListener::BundleTick, const BundleList& aTickBundles, uint64_t /*aTick*/) noexcept {
 		for (const auto& b : aTickBundles) {
-			onBundleUpdated(b, TICK_PROPS, "queue_bundle_tick");
+			bundleView.onItemUpdated(b, QueueEventPublisher::bundleTickProperties);
 		}
 	}
 
 	void QueueApi::on(QueueManagerListener::BundleDownloadStatus, const BundlePtr& aBundle) noexcept {
-		// "Waiting" isn't really a status (it's just meant to clear the props for running bundles...)
-		onBundleUpdated(aBundle, TICK_PROPS, "queue_bundle_tick");
+		bundleView.onItemUpdated(aBundle, QueueEventPublisher::bundleTickProperties);
 	}
-}
\ No newline at end of file
+}
@@ -28,6 +28,7 @@
 #include <api/base/HookApiModule.h>
 
 #include <api/QueueBundleUtils.h>
+#include <api/QueueEventPublisher.h>
 #include <api/QueueFileUtils.h>
 
 namespace dcpp {
@@ -124,15 +125,14 @@ namespace webserver {
 		void on(QueueManagerListener::ItemPriority, const QueueItemPtr& aQI) noexcept override;
 		void on(QueueManagerListener::ItemTick, const QueueItemPtr& aQI) noexcept override;
 
-		void onFileUpdated(const QueueItemPtr& aQI, const PropertyIdSet& aUpdatedProperties, const string& aSubscription);
-		void onBundleUpdated(const BundlePtr& aBundle, const PropertyIdSet& aUpdatedProperties, const string& aSubscription);
-
 		using BundleListView = ListViewController<BundlePtr, QueueBundleUtils::PROP_LAST>;
 		BundleListView bundleView;
 
 		using FileListView = ListViewController<QueueItemPtr, QueueFileUtils::PROP_LAST>;
 		FileListView fileView;
 
+		std::shared_ptr<QueueEventPublisher> eventPublisher;
+
 		static BundleList getBundleList() noexcept;
 		static QueueItemList getFileList() noexcept;
 	};
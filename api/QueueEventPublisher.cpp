@@ -0,0 +1,183 @@
+/*
+* Copyright (C) 2011-2024 AirDC++ Project
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+*/
+
+#include "stdinc.h"
+
+#include <web-server/EventBus.h>
+
+#include <api/QueueEventPublisher.h>
+#include <api/QueueBundleUtils.h>
+#include <api/QueueFileUtils.h>
+#include <api/common/Serializer.h>
+
+#include <airdcpp/transfer/download/DownloadManager.h>
+#include <airdcpp/queue/QueueManager.h>
+
+namespace webserver {
+	const StringList QueueEventPublisher::subscriptions = {
+		"queue_bundle_added",
+		"queue_bundle_removed",
+		"queue_bundle_updated",
+
+		// These are included in queue_bundle_updated events as well
+		"queue_bundle_tick",
+		"queue_bundle_content",
+		"queue_bundle_priority",
+		"queue_bundle_status",
+		"queue_bundle_sources",
+
+		"queue_file_added",
+		"queue_file_removed",
+		"queue_file_updated",
+
+		// These are included in queue_file_updated events as well
+		"queue_file_priority",
+		"queue_file_status",
+		"queue_file_sources",
+		"queue_file_tick",
+	};
+
+	const PropertyIdSet QueueEventPublisher::bundleContentProperties = { QueueBundleUtils::PROP_SIZE, QueueBundleUtils::PROP_TYPE };
+	const PropertyIdSet QueueEventPublisher::bundlePriorityProperties = { QueueBundleUtils::PROP_PRIORITY, QueueBundleUtils::PROP_STATUS };
+	const PropertyIdSet QueueEventPublisher::bundleStatusProperties = { QueueBundleUtils::PROP_STATUS, QueueBundleUtils::PROP_TIME_FINISHED };
+	const PropertyIdSet QueueEventPublisher::bundleSourceProperties = { QueueBundleUtils::PROP_SOURCES };
+	const PropertyIdSet QueueEventPublisher::bundleTickProperties = { 
+		QueueBundleUtils::PROP_SECONDS_LEFT, QueueBundleUtils::PROP_SPEED, QueueBundleUtils::PROP_STATUS, QueueBundleUtils::PROP_BYTES_DOWNLOADED 
+	};
+
+	const PropertyIdSet QueueEventPublisher::fileSourceProperties = { QueueFileUtils::PROP_SOURCES };
+	const PropertyIdSet QueueEventPublisher::fileStatusProperties = {
+		QueueFileUtils::PROP_STATUS, QueueFileUtils::PROP_TIME_FINISHED, QueueFileUtils::PROP_BYTES_DOWNLOADED,
+		QueueFileUtils::PROP_SECONDS_LEFT, QueueFileUtils::PROP_SPEED
+	};
+	const PropertyIdSet QueueEventPublisher::filePriorityProperties = { QueueFileUtils::PROP_STATUS, QueueFileUtils::PROP_PRIORITY };
+	const PropertyIdSet QueueEventPublisher::fileTickProperties = {
+		QueueFileUtils::PROP_STATUS, QueueFileUtils::PROP_BYTES_DOWNLOADED,
+		QueueFileUtils::PROP_SECONDS_LEFT, QueueFileUtils::PROP_SPEED
+	};
+
+	QueueEventPublisher::QueueEventPublisher(EventBus& aEventBus) : eventBus(aEventBus) {
+		QueueManager::getInstance()->addListener(this);
+		DownloadManager::getInstance()->addListener(this);
+	}
+
+	QueueEventPublisher::~QueueEventPublisher() {
+		QueueManager::getInstance()->removeListener(this);
+		DownloadManager::getInstance()->removeListener(this);
+	}
+
+
+	// FILE LISTENERS
+	void QueueEventPublisher::on(QueueManagerListener::ItemAdded, const QueueItemPtr& aQI) noexcept {
+		eventBus.publish("queue_file_added", [&] {
+			return Serializer::serializeItem(aQI, QueueFileUtils::propertyHandler);
+		});
+	}
+
+	void QueueEventPublisher::on(QueueManagerListener::ItemRemoved, const QueueItemPtr& aQI, bool /*finished*/) noexcept {
+		eventBus.publish("queue_file_removed", [&] {
+			return Serializer::serializeItem(aQI, QueueFileUtils::propertyHandler);
+		});
+	}
+
+	void QueueEventPublisher::onFileUpdated(const QueueItemPtr& aQI, const PropertyIdSet& aUpdatedProperties, const string& aSubscription) noexcept {
+		// Serialize full item for more specific updates to make reading of data easier 
+		// (such as cases when the script is interested only in finished files)
+		eventBus.publish(aSubscription, [&] {
+			return Serializer::serializeItem(aQI, QueueFileUtils::propertyHandler);
+		});
+
+		// Serialize updated properties only
+		// (but always include the bundle ID as well)
+		eventBus.publish("queue_file_updated", [&] {
+			auto propertiesWithBundle = aUpdatedProperties;
+			propertiesWithBundle.insert(QueueFileUtils::PROP_BUNDLE);
+			return Serializer::serializePartialItem(aQI, QueueFileUtils::propertyHandler, propertiesWithBundle);
+		});
+	}
+
+	void QueueEventPublisher::on(QueueManagerListener::ItemSources, const QueueItemPtr& aQI) noexcept {
+		onFileUpdated(aQI, fileSourceProperties, "queue_file_sources");
+	}
+
+	void QueueEventPublisher::on(QueueManagerListener::ItemStatus, const QueueItemPtr& aQI) noexcept {
+		onFileUpdated(aQI, fileStatusProperties, "queue_file_status");
+	}
+
+	void QueueEventPublisher::on(QueueManagerListener::ItemPriority, const QueueItemPtr& aQI) noexcept {
+		onFileUpdated(aQI, filePriorityProperties, "queue_file_priority");
+	}
+
+	void QueueEventPublisher::on(QueueManagerListener::ItemTick, const QueueItemPtr& aQI) noexcept {
+		onFileUpdated(aQI, fileTickProperties, "queue_file_tick");
+	}
+
+
+	// BUNDLE LISTENERS
+	void QueueEventPublisher::on(QueueManagerListener::BundleAdded, const BundlePtr& aBundle) noexcept {
+		eventBus.publish("queue_bundle_added", [&] {
+			return Serializer::serializeItem(aBundle, QueueBundleUtils::propertyHandler);
+		});
+	}
+
+	void QueueEventPublisher::on(QueueManagerListener::BundleRemoved, const BundlePtr& aBundle) noexcept {
+		eventBus.publish("queue_bundle_removed", [&] {
+			return Serializer::serializeItem(aBundle, QueueBundleUtils::propertyHandler);
+		});
+	}
+
+	void QueueEventPublisher::onBundleUpdated(const BundlePtr& aBundle, const PropertyIdSet& aUpdatedProperties, const string& aSubscription) noexcept {
+		// Serialize full item for more specific updates to make reading of data easier 
+		// (such as cases when the script is interested only in finished bundles)
+		eventBus.publish(aSubscription, [&] {
+			return Serializer::serializeItem(aBundle, QueueBundleUtils::propertyHandler);
+		});
+
+		// Serialize updated properties only
+		eventBus.publish("queue_bundle_updated", [&] {
+			return Serializer::serializePartialItem(aBundle, QueueBundleUtils::propertyHandler, aUpdatedProperties);
+		});
+	}
+
+	void QueueEventPublisher::on(QueueManagerListener::BundleSize, const BundlePtr& aBundle) noexcept {
+		onBundleUpdated(aBundle, bundleContentProperties, "queue_bundle_content");
+	}
+
+	void QueueEventPublisher::on(QueueManagerListener::BundlePriority, const BundlePtr& aBundle) noexcept {
+		onBundleUpdated(aBundle, bundlePriorityProperties, "queue_bundle_priority");
+	}
+
+	void QueueEventPublisher::on(QueueManagerListener::BundleStatusChanged, const BundlePtr& aBundle) noexcept {
+		onBundleUpdated(aBundle, bundleStatusProperties, "queue_bundle_status");
+	}
+
+	void QueueEventPublisher::on(QueueManagerListener::BundleSources, const BundlePtr& aBundle) noexcept {
+		onBundleUpdated(aBundle, bundleSourceProperties, "queue_bundle_sources");
+	}
+
+	void QueueEventPublisher::on(DownloadManagerListener::BundleTick, const BundleList& aTickBundles, uint64_t /*aTick*/) noexcept {
+		for (const auto& b : aTickBundles) {
+			onBundleUpdated(b, bundleTickProperties, "queue_bundle_tick");
+		}
+	}
+
+	void QueueEventPublisher::on(QueueManagerListener::BundleDownloadStatus, const BundlePtr& aBundle) noexcept {
+		// "Waiting" isn't really a status (it's just meant to clear the props for running bundles...)
+		onBundleUpdated(aBundle, bundleTickProperties, "queue_bundle_tick");
+	}
+}
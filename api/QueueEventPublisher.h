@@ -0,0 +1,81 @@
+/*
+* Copyright (C) 2011-2024 AirDC++ Project
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+*/
+
+#ifndef DCPLUSPLUS_DCPP_QUEUEEVENTPUBLISHER_H
+#define DCPLUSPLUS_DCPP_QUEUEEVENTPUBLISHER_H
+
+#include <airdcpp/core/header/typedefs.h>
+
+#include <airdcpp/transfer/download/DownloadManagerListener.h>
+#include <airdcpp/queue/QueueManagerListener.h>
+
+#include <api/common/Property.h>
+
+namespace webserver {
+	class EventBus;
+
+	// Queue events for all sessions (see EventBus)
+	class QueueEventPublisher : private QueueManagerListener, private DownloadManagerListener {
+	public:
+		explicit QueueEventPublisher(EventBus& aEventBus);
+		~QueueEventPublisher() override;
+
+		static const StringList subscriptions;
+
+		// Updated properties of each event (list views use these as well)
+		static const PropertyIdSet bundleContentProperties;
+		static const PropertyIdSet bundlePriorityProperties;
+		static const PropertyIdSet bundleStatusProperties;
+		static const PropertyIdSet bundleSourceProperties;
+		static const PropertyIdSet bundleTickProperties;
+
+		static const PropertyIdSet fileSourceProperties;
+		static const PropertyIdSet fileStatusProperties;
+		static const PropertyIdSet filePriorityProperties;
+		static const PropertyIdSet fileTickProperties;
+
+		QueueEventPublisher(QueueEventPublisher&) = delete;
+		QueueEventPublisher& operator=(QueueEventPublisher&) = delete;
+	private:
+		void onFileUpdated(const QueueItemPtr& aQI, const PropertyIdSet& aUpdatedProperties, const string& aSubscription) noexcept;
+		void onBundleUpdated(const BundlePtr& aBundle, const PropertyIdSet& aUpdatedProperties, const string& aSubscription) noexcept;
+
+		// Bundle update listeners
+		void on(QueueManagerListener::BundleAdded, const BundlePtr& aBundle) noexcept override;
+		void on(QueueManagerListener::BundleRemoved, const BundlePtr& aBundle) noexcept override;
+		void on(QueueManagerListener::BundleSize, const BundlePtr& aBundle) noexcept override;
+		void on(QueueManagerListener::BundlePriority, const BundlePtr& aBundle) noexcept override;
+		void on(QueueManagerListener::BundleStatusChanged, const BundlePtr& aBundle) noexcept override;
+		void on(QueueManagerListener::BundleSources, const BundlePtr& aBundle) noexcept override;
+		void on(QueueManagerListener::BundleDownloadStatus, const BundlePtr& aBundle) noexcept override;
+
+		void on(DownloadManagerListener::BundleTick, const BundleList& aTickBundles, uint64_t aTick) noexcept override;
+
+		// QueueItem update listeners
+		void on(QueueManagerListener::ItemAdded, const QueueItemPtr& aQI) noexcept override;
+		void on(QueueManagerListener::ItemRemoved, const QueueItemPtr& aQI, bool /*finished*/) noexcept override;
+		void on(QueueManagerListener::ItemSources, const QueueItemPtr& aQI) noexcept override;
+		void on(QueueManagerListener::ItemStatus, const QueueItemPtr& aQI) noexcept override;
+		void on(QueueManagerListener::ItemPriority, const QueueItemPtr& aQI) noexcept override;
+		void on(QueueManagerListener::ItemTick, const QueueItemPtr& aQI) noexcept override;
+
+		EventBus& eventBus;
+	};
+}
+
+#endif
@@ -281,6 +281,6 @@ namespace webserver {
 
 
 	string SearchApi::parseSearchTypeId(ApiRequest& aRequest) noexcept {
-		return FileSearchParser::parseSearchType(aRequest.getStringParam(SEARCH_TYPE_ID));
+		return FileSearchParser::parseSearchType(string(aRequest.getStringParam(SEARCH_TYPE_ID)));
 	}
 }
\ No newline at end of file
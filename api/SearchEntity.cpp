@@ -71,9 +71,7 @@ namespace webserver {
 
 	api_return SearchEntity::handleGetResults(ApiRequest& aRequest) {
 		// Serialize the most relevant results first
-		auto j = Serializer::serializeItemList(aRequest.getRangeParam(START_POS), aRequest.getRangeParam(MAX_COUNT), SearchUtils::propertyHandler, search->getResultSet());
-
-		aRequest.setResponseBody(j);
+		aRequest.setResponseBodyRaw(Serializer::writeItemList(aRequest.getRangeParam(START_POS), aRequest.getRangeParam(MAX_COUNT), SearchUtils::propertyHandler, search->getResultSet()));
 		return http::status::ok;
 	}
 
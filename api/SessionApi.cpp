@@ -134,6 +134,7 @@ namespace webserver {
 		dcassert(session);
 
 		if (aRequest.authenticationCallback) {
+			session->setConcurrentRequests(JsonUtil::getOptionalFieldDefault<bool>("concurrent_requests", reqJson, false));
 			aRequest.authenticationCallback(session);
 		}
 
@@ -179,6 +180,7 @@ namespace webserver {
 			return http::status::bad_request;
 		}
 
+		session->setConcurrentRequests(JsonUtil::getOptionalFieldDefault<bool>("concurrent_requests", apiRequest.getRequestBody(), false));
 		aRequest.authenticationCallback(session);
 
 		apiRequest.setResponseBody(serializeLoginInfo(session, Util::emptyString));
@@ -68,8 +68,8 @@ namespace webserver {
 		// Methods
 		METHOD_HANDLER(Access::ANY,			METHOD_GET,		(EXACT_PARAM("grouped_root_paths")),				ShareApi::handleGetGroupedRootPaths);
 		METHOD_HANDLER(Access::SHARE_VIEW,	METHOD_GET,		(EXACT_PARAM("stats")),								ShareApi::handleGetStats);
-		METHOD_HANDLER(Access::ANY,			METHOD_POST,	(EXACT_PARAM("find_dupe_paths")),					ShareApi::handleFindDupePaths);
-		METHOD_HANDLER(Access::SHARE_VIEW,	METHOD_POST,	(EXACT_PARAM("search")),							ShareApi::handleSearch);
+		METHOD_HANDLER_COST(Access::ANY,		METHOD_POST,	(EXACT_PARAM("find_dupe_paths")),					ShareApi::handleFindDupePaths, 5);
+		METHOD_HANDLER_COST(Access::SHARE_VIEW,	METHOD_POST,	(EXACT_PARAM("search")),							ShareApi::handleSearch, 5);
 		METHOD_HANDLER(Access::ANY,			METHOD_POST,	(EXACT_PARAM("validate_path")),						ShareApi::handleValidatePath);
 		METHOD_HANDLER(Access::ANY,			METHOD_POST,	(EXACT_PARAM("check_path_shared")),					ShareApi::handleIsPathShared);
 
@@ -67,8 +67,7 @@ namespace webserver {
 	}
 
 	api_return ShareRootApi::handleGetRoots(ApiRequest& aRequest) {
-		auto j = Serializer::serializeItemList(ShareUtils::propertyHandler, ShareManager::getInstance()->getRootInfos());
-		aRequest.setResponseBody(j);
+		aRequest.setResponseBodyRaw(Serializer::writeItemList(ShareUtils::propertyHandler, ShareManager::getInstance()->getRootInfos()));
 		return http::status::ok;
 	}
 
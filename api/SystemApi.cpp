@@ -19,7 +19,12 @@
 #include "stdinc.h"
 #include <web-server/version.h>
 
+#include <web-server/ApiMetrics.h>
+#include <web-server/EventBus.h>
+#include <web-server/FileServer.h>
+#include <web-server/HttpManager.h>
 #include <web-server/JsonUtil.h>
+#include <web-server/RateLimiter.h>
 #include <web-server/SystemUtil.h>
 #include <web-server/Timer.h>
 #include <web-server/WebServerManager.h>
@@ -41,6 +46,7 @@ namespace webserver {
 		createSubscriptions({ "away_state" });
 
 		METHOD_HANDLER(Access::ANY, METHOD_GET,		(EXACT_PARAM("stats")),			SystemApi::handleGetStats);
+		METHOD_HANDLER(Access::ADMIN, METHOD_GET,	(EXACT_PARAM("metrics")),		SystemApi::handleGetMetrics);
 
 		METHOD_HANDLER(Access::ANY, METHOD_GET,		(EXACT_PARAM("away")),			SystemApi::handleGetAwayState);
 		METHOD_HANDLER(Access::ANY, METHOD_POST,	(EXACT_PARAM("away")),			SystemApi::handleSetAway);
@@ -131,14 +137,57 @@ namespace webserver {
 
 	api_return SystemApi::handleGetStats(ApiRequest& aRequest) {
 		auto server = session->getServer();
+		auto socketQueue = server->getWsSendQueueStats();
+		auto rateLimiterStats = server->getRateLimiter().getStats();
+		auto assetCacheStats = server->getHttpManager().getFileServer().getAssetCacheStats();
+		auto eventBusStats = server->getEventBus().getStats();
+
+		auto moduleInitTimes = json::object();
+		for (const auto& [apiModule, stats]: server->getUserManager().getModuleInitStats()) {
+			moduleInitTimes[apiModule] = {
+				{ "count", stats.count },
+				{ "average_us", stats.totalMicros / stats.count },
+				{ "max_us", stats.maxMicros },
+			};
+		}
 
 		aRequest.setResponseBody({
 			{ "server_threads", WEBCFG(SERVER_THREADS).num() },
 			{ "active_sessions", server->getUserManager().getUserSessionCount() },
+			{ "socket_send_queue", {
+				{ "messages", socketQueue.queuedMessages },
+				{ "bytes", socketQueue.queuedBytes },
+				{ "coalesced_messages", socketQueue.coalescedMessages },
+				{ "dropped_messages", socketQueue.droppedMessages },
+				{ "disconnected_clients", socketQueue.disconnectedClients },
+			} },
+			{ "module_init_times", moduleInitTimes },
+			{ "rate_limiter", {
+				{ "admitted_requests", rateLimiterStats.admitted },
+				{ "queued_requests", rateLimiterStats.queued },
+				{ "rejected_requests", rateLimiterStats.rejected },
+			} },
+			{ "asset_cache", {
+				{ "assets", assetCacheStats.assets },
+				{ "bytes", assetCacheStats.bytes },
+				{ "hits", assetCacheStats.hits },
+				{ "misses", assetCacheStats.misses },
+				{ "evictions", assetCacheStats.evictions },
+			} },
+			{ "shared_events", {
+				{ "published", eventBusStats.published },
+				{ "deliveries", eventBusStats.deliveries },
+			} },
 		});
 		return http::status::ok;
 	}
 
+	api_return SystemApi::handleGetMetrics(ApiRequest& aRequest) {
+		auto server = session->getServer();
+		aRequest.setResponseBody(server->getMetrics().toJson(server->getWsSendQueueStats()));
+		return http::status::ok;
+	}
+
 	json SystemApi::getSystemInfo() noexcept {
 		auto started = TimerManager::getStartTime();
 		return {
@@ -39,6 +39,7 @@ namespace webserver {
 		api_return handleSetAway(ApiRequest& aRequest);
 
 		api_return handleGetStats(ApiRequest& aRequest);
+		api_return handleGetMetrics(ApiRequest& aRequest);
 		api_return handleRestartWeb(ApiRequest& aRequest);
 		api_return handleShutdown(ApiRequest& aRequest);
 
@@ -18,7 +18,10 @@
 
 #include "stdinc.h"
 
+#include <web-server/EventBus.h>
+#include <web-server/Session.h>
 #include <web-server/Timer.h>
+#include <web-server/WebServerManager.h>
 
 #include <api/TransferApi.h>
 
@@ -37,20 +40,16 @@ namespace webserver {
 	TransferApi::TransferApi(Session* aSession) : 
 		SubscribableApiModule(aSession, Access::TRANSFERS),
 		timer(getTimer([this] { onTimer(); }, 1000)),
-		view("transfer_view", this, TransferUtils::propertyHandler, std::bind(&TransferApi::getTransfers, this))
+		view("transfer_view", this, TransferUtils::propertyHandler, std::bind(&TransferApi::getTransfers, this)),
+		eventPublisher(aSession->getServer()->getEventBus().getPublisher<TransferEventPublisher>())
 	{
 		createSubscriptions({
 			"transfer_statistics",
-			"transfer_added",
-			"transfer_updated",
-			"transfer_removed",
-
-			// These are included in transfer_updated events as well
-			"transfer_starting",
-			"transfer_completed",
-			"transfer_failed",
 		});
 
+		// Events are serialized once for all sessions
+		createSharedSubscriptions(TransferEventPublisher::subscriptions);
+
 		METHOD_HANDLER(Access::TRANSFERS,	METHOD_GET,		(),											TransferApi::handleGetTransfers);
 		METHOD_HANDLER(Access::TRANSFERS,	METHOD_GET,		(TOKEN_PARAM),								TransferApi::handleGetTransfer);
 
@@ -63,13 +62,13 @@ namespace webserver {
 
 		timer->start(false);
 
-		TransferInfoManager::getInstance()->addListener(this);
+		eventPublisher->addListener(this);
 	}
 
 	TransferApi::~TransferApi() {
 		timer->stop(true);
 
-		TransferInfoManager::getInstance()->removeListener(this);
+		eventPublisher->removeListener(this);
 	}
 
 	TransferInfo::List TransferApi::getTransfers() const noexcept {
@@ -77,8 +76,7 @@ namespace webserver {
 	}
 
 	api_return TransferApi::handleGetTransfers(ApiRequest& aRequest) {
-		auto j = Serializer::serializeItemList(TransferUtils::propertyHandler, getTransfers());
-		aRequest.setResponseBody(j);
+		aRequest.setResponseBodyRaw(Serializer::writeItemList(TransferUtils::propertyHandler, getTransfers()));
 		return http::status::ok;
 	}
 
@@ -177,81 +175,16 @@ namespace webserver {
 		previousStats.swap(newStats);
 	}
 
-	void TransferApi::on(TransferInfoManagerListener::Added, const TransferInfoPtr& aInfo) noexcept {
+	// Events are sent by TransferEventPublisher
+	void TransferApi::on(TransferEventPublisherListener::Added, const TransferInfoPtr& aInfo) noexcept {
 		view.onItemAdded(aInfo);
-		if (subscriptionActive("transfer_added")) {
-			send("transfer_added", Serializer::serializeItem(aInfo, TransferUtils::propertyHandler));
-		}
-	}
-
-	PropertyIdSet TransferApi::updateFlagsToPropertyIds(int aUpdatedProperties) noexcept {
-		PropertyIdSet updatedProps;
-		if (aUpdatedProperties & TransferInfo::UpdateFlags::TARGET)
-			updatedProps.insert(TransferUtils::PROP_TARGET);
-			updatedProps.insert(TransferUtils::PROP_NAME);
-		if (aUpdatedProperties & TransferInfo::UpdateFlags::TYPE)
-			updatedProps.insert(TransferUtils::PROP_TYPE);
-		if (aUpdatedProperties & TransferInfo::UpdateFlags::SIZE)
-			updatedProps.insert(TransferUtils::PROP_SIZE);
-		if (aUpdatedProperties & TransferInfo::UpdateFlags::STATUS)
-			updatedProps.insert(TransferUtils::PROP_STATUS);
-		if (aUpdatedProperties & TransferInfo::UpdateFlags::BYTES_TRANSFERRED)
-			updatedProps.insert(TransferUtils::PROP_BYTES_TRANSFERRED);
-		if (aUpdatedProperties & TransferInfo::UpdateFlags::USER)
-			updatedProps.insert(TransferUtils::PROP_USER);
-		if (aUpdatedProperties & TransferInfo::UpdateFlags::TIME_STARTED)
-			updatedProps.insert(TransferUtils::PROP_TIME_STARTED);
-		if (aUpdatedProperties & TransferInfo::UpdateFlags::SPEED)
-			updatedProps.insert(TransferUtils::PROP_SPEED);
-		if (aUpdatedProperties & TransferInfo::UpdateFlags::SECONDS_LEFT)
-			updatedProps.insert(TransferUtils::PROP_SECONDS_LEFT);
-		if (aUpdatedProperties & TransferInfo::UpdateFlags::IP)
-			updatedProps.insert(TransferUtils::PROP_IP);
-		if (aUpdatedProperties & TransferInfo::UpdateFlags::FLAGS)
-			updatedProps.insert(TransferUtils::PROP_FLAGS);
-		if (aUpdatedProperties & TransferInfo::UpdateFlags::SUPPORTS)
-			updatedProps.insert(TransferUtils::PROP_SUPPORTS);
-		if (aUpdatedProperties & TransferInfo::UpdateFlags::ENCRYPTION)
-			updatedProps.insert(TransferUtils::PROP_ENCRYPTION);
-		if (aUpdatedProperties & TransferInfo::UpdateFlags::QUEUE_ID)
-			updatedProps.insert(TransferUtils::PROP_QUEUE_ID);
-		if (aUpdatedProperties & TransferInfo::UpdateFlags::STATE)
-			updatedProps.insert(TransferUtils::PROP_STATUS);
-
-		return updatedProps;
 	}
 
-	void TransferApi::on(TransferInfoManagerListener::Updated, const TransferInfoPtr& aInfo, int aUpdatedProperties, bool aTick) noexcept {
-		auto updatedProps = updateFlagsToPropertyIds(aUpdatedProperties);
-
-		view.onItemUpdated(aInfo, updatedProps);
-		if (subscriptionActive("transfer_updated")) {
-			send("transfer_updated", Serializer::serializePartialItem(aInfo, TransferUtils::propertyHandler, updatedProps));
-		}
+	void TransferApi::on(TransferEventPublisherListener::Updated, const TransferInfoPtr& aInfo, const PropertyIdSet& aUpdatedProperties) noexcept {
+		view.onItemUpdated(aInfo, aUpdatedProperties);
 	}
 
-	void TransferApi::on(TransferInfoManagerListener::Removed, const TransferInfoPtr& aInfo) noexcept {
+	void TransferApi::on(TransferEventPublisherListener::Removed, const TransferInfoPtr& aInfo) noexcept {
 		view.onItemRemoved(aInfo);
-		if (subscriptionActive("transfer_removed")) {
-			send("transfer_removed", Serializer::serializeItem(aInfo, TransferUtils::propertyHandler));
-		}
-	}
-
-	void TransferApi::on(TransferInfoManagerListener::Failed, const TransferInfoPtr& aInfo) noexcept { 
-		if (subscriptionActive("transfer_failed")) {
-			send("transfer_failed", Serializer::serializeItem(aInfo, TransferUtils::propertyHandler));
-		}
-	}
-
-	void TransferApi::on(TransferInfoManagerListener::Starting, const TransferInfoPtr& aInfo) noexcept {
-		if (subscriptionActive("transfer_starting")) {
-			send("transfer_starting", Serializer::serializeItem(aInfo, TransferUtils::propertyHandler));
-		}
-	}
-
-	void TransferApi::on(TransferInfoManagerListener::Completed, const TransferInfoPtr& aInfo) noexcept {
-		if (subscriptionActive("transfer_completed")) {
-			send("transfer_completed", Serializer::serializeItem(aInfo, TransferUtils::propertyHandler));
-		}
 	}
-}
\ No newline at end of file
+}
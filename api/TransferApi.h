@@ -20,17 +20,16 @@
 #define DCPLUSPLUS_DCPP_TRANSFERAPI_H
 
 #include <api/base/SubscribableApiModule.h>
+#include <api/TransferEventPublisher.h>
 #include <api/TransferUtils.h>
 
 #include <api/common/ListViewController.h>
 
 #include <airdcpp/core/header/typedefs.h>
 
-#include <airdcpp/transfer/TransferInfoManagerListener.h>
-
 
 namespace webserver {
-	class TransferApi : public SubscribableApiModule, private TransferInfoManagerListener {
+	class TransferApi : public SubscribableApiModule, private TransferEventPublisherListener {
 	public:
 		TransferApi(Session* aSession);
 		~TransferApi();
@@ -47,12 +46,9 @@ namespace webserver {
 
 		void onTimer();
 
-		void on(TransferInfoManagerListener::Added, const TransferInfoPtr& aInfo) noexcept override;
-		void on(TransferInfoManagerListener::Updated, const TransferInfoPtr& aInfo, int aUpdatedProperties, bool aTick) noexcept override;
-		void on(TransferInfoManagerListener::Removed, const TransferInfoPtr& aInfo) noexcept override;
-		void on(TransferInfoManagerListener::Failed, const TransferInfoPtr& aInfo) noexcept override;
-		void on(TransferInfoManagerListener::Starting, const TransferInfoPtr& aInfo) noexcept override;
-		void on(TransferInfoManagerListener::Completed, const TransferInfoPtr& aInfo) noexcept override;
+		void on(TransferEventPublisherListener::Added, const TransferInfoPtr& aInfo) noexcept override;
+		void on(TransferEventPublisherListener::Updated, const TransferInfoPtr& aInfo, const PropertyIdSet& aUpdatedProperties) noexcept override;
+		void on(TransferEventPublisherListener::Removed, const TransferInfoPtr& aInfo) noexcept override;
 
 		json previousStats;
 
@@ -61,9 +57,10 @@ namespace webserver {
 		typedef ListViewController<TransferInfoPtr, TransferUtils::PROP_LAST> TransferListView;
 		TransferListView view;
 
+		std::shared_ptr<TransferEventPublisher> eventPublisher;
+
 		TransferInfoPtr getTransfer(ApiRequest& aRequest) const;
 		TransferInfo::List getTransfers() const noexcept;
-		static PropertyIdSet updateFlagsToPropertyIds(int aUpdatedProperties) noexcept;
 	};
 }
 
@@ -0,0 +1,85 @@
+/*
+* Copyright (C) 2011-2024 AirDC++ Project
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+*/
+
+#include "stdinc.h"
+
+#include <web-server/EventBus.h>
+
+#include <api/TransferEventPublisher.h>
+#include <api/TransferUtils.h>
+#include <api/common/Serializer.h>
+
+#include <airdcpp/transfer/TransferInfoManager.h>
+
+namespace webserver {
+	const StringList TransferEventPublisher::subscriptions = {
+		"transfer_added",
+		"transfer_updated",
+		"transfer_removed",
+
+		// These are included in transfer_updated events as well
+		"transfer_starting",
+		"transfer_completed",
+		"transfer_failed",
+	};
+
+	TransferEventPublisher::TransferEventPublisher(EventBus& aEventBus) : eventBus(aEventBus) {
+		TransferInfoManager::getInstance()->addListener(this);
+	}
+
+	TransferEventPublisher::~TransferEventPublisher() {
+		TransferInfoManager::getInstance()->removeListener(this);
+	}
+
+	void TransferEventPublisher::publishItem(const string& aSubscription, const TransferInfoPtr& aInfo) noexcept {
+		eventBus.publish(aSubscription, [&] {
+			return Serializer::serializeItem(aInfo, TransferUtils::propertyHandler);
+		});
+	}
+
+	void TransferEventPublisher::on(TransferInfoManagerListener::Added, const TransferInfoPtr& aInfo) noexcept {
+		publishItem("transfer_added", aInfo);
+		fire(TransferEventPublisherListener::Added(), aInfo);
+	}
+
+	void TransferEventPublisher::on(TransferInfoManagerListener::Updated, const TransferInfoPtr& aInfo, int aUpdatedProperties, bool /*aTick*/) noexcept {
+		const auto updatedProperties = TransferUtils::updateFlagsToPropertyIds(aUpdatedProperties);
+		eventBus.publish("transfer_updated", [&] {
+			return Serializer::serializePartialItem(aInfo, TransferUtils::propertyHandler, updatedProperties);
+		});
+
+		fire(TransferEventPublisherListener::Updated(), aInfo, updatedProperties);
+	}
+
+	void TransferEventPublisher::on(TransferInfoManagerListener::Removed, const TransferInfoPtr& aInfo) noexcept {
+		publishItem("transfer_removed", aInfo);
+		fire(TransferEventPublisherListener::Removed(), aInfo);
+	}
+
+	void TransferEventPublisher::on(TransferInfoManagerListener::Failed, const TransferInfoPtr& aInfo) noexcept {
+		publishItem("transfer_failed", aInfo);
+	}
+
+	void TransferEventPublisher::on(TransferInfoManagerListener::Starting, const TransferInfoPtr& aInfo) noexcept {
+		publishItem("transfer_starting", aInfo);
+	}
+
+	void TransferEventPublisher::on(TransferInfoManagerListener::Completed, const TransferInfoPtr& aInfo) noexcept {
+		publishItem("transfer_completed", aInfo);
+	}
+}
@@ -0,0 +1,57 @@
+/*
+* Copyright (C) 2011-2024 AirDC++ Project
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+*/
+
+#ifndef DCPLUSPLUS_DCPP_TRANSFEREVENTPUBLISHER_H
+#define DCPLUSPLUS_DCPP_TRANSFEREVENTPUBLISHER_H
+
+#include <api/TransferEventPublisherListener.h>
+
+#include <airdcpp/core/header/typedefs.h>
+#include <airdcpp/core/Speaker.h>
+
+#include <airdcpp/transfer/TransferInfoManagerListener.h>
+
+namespace webserver {
+	class EventBus;
+
+	// Transfer events for all sessions (see EventBus)
+	// The events are also forwarded to the listeners so that the updated properties are parsed only once
+	class TransferEventPublisher : public Speaker<TransferEventPublisherListener>, private TransferInfoManagerListener {
+	public:
+		explicit TransferEventPublisher(EventBus& aEventBus);
+		~TransferEventPublisher() override;
+
+		static const StringList subscriptions;
+
+		TransferEventPublisher(TransferEventPublisher&) = delete;
+		TransferEventPublisher& operator=(TransferEventPublisher&) = delete;
+	private:
+		void on(TransferInfoManagerListener::Added, const TransferInfoPtr& aInfo) noexcept override;
+		void on(TransferInfoManagerListener::Updated, const TransferInfoPtr& aInfo, int aUpdatedProperties, bool aTick) noexcept override;
+		void on(TransferInfoManagerListener::Removed, const TransferInfoPtr& aInfo) noexcept override;
+		void on(TransferInfoManagerListener::Failed, const TransferInfoPtr& aInfo) noexcept override;
+		void on(TransferInfoManagerListener::Starting, const TransferInfoPtr& aInfo) noexcept override;
+		void on(TransferInfoManagerListener::Completed, const TransferInfoPtr& aInfo) noexcept override;
+
+		void publishItem(const string& aSubscription, const TransferInfoPtr& aInfo) noexcept;
+
+		EventBus& eventBus;
+	};
+}
+
+#endif
@@ -16,39 +16,28 @@
 * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
 */
 
-#ifndef DCPLUSPLUS_WEBSERVER_LAZYWRAPPER_H
-#define DCPLUSPLUS_WEBSERVER_LAZYWRAPPER_H
+#ifndef DCPLUSPLUS_DCPP_TRANSFEREVENTPUBLISHERLISTENER_H
+#define DCPLUSPLUS_DCPP_TRANSFEREVENTPUBLISHERLISTENER_H
 
-#include "forward.h"
+#include <airdcpp/core/header/typedefs.h>
 
-namespace webserver {
-	template <class T>
+#include <api/common/Property.h>
 
-	// NOTE: initialization is not thread safe
-	class LazyInitWrapper {
+namespace webserver {
+	class TransferEventPublisherListener {
 	public:
-		using InitF = std::function<unique_ptr<T> ()>;
-		explicit LazyInitWrapper(InitF&& aInitF) : initF(std::move(aInitF)) {}
-
-		T* operator->() {
-			ensureInit();
-			return apiModule.operator->();
-		}
-
-		T* get() {
-			ensureInit();
-			return apiModule.get();
-		}
-	private:
-		void ensureInit() {
-			if (!apiModule) {
-				apiModule = initF();
-			}
-		}
-
-		unique_ptr<T> apiModule;
-		InitF initF;
+		virtual ~TransferEventPublisherListener() { }
+		template<int I>	struct X { enum { TYPE = I }; };
+
+		typedef X<0> Added;
+		typedef X<1> Updated;
+		typedef X<2> Removed;
+
+		virtual void on(Added, const TransferInfoPtr&) noexcept { }
+		virtual void on(Updated, const TransferInfoPtr&, const PropertyIdSet& /*aUpdatedProperties*/) noexcept { }
+		virtual void on(Removed, const TransferInfoPtr&) noexcept { }
 	};
+
 }
 
-#endif
\ No newline at end of file
+#endif // !defined(DCPLUSPLUS_DCPP_TRANSFEREVENTPUBLISHERLISTENER_H)
@@ -57,6 +57,9 @@ namespace webserver {
 		static std::string getStringInfo(const TransferInfoPtr& aItem, int aPropertyName) noexcept;
 		static double getNumericInfo(const TransferInfoPtr& aItem, int aPropertyName) noexcept;
 		static string serializeStateKey(TransferInfo::ItemState aState) noexcept;
+
+		// Converts TransferInfo::UpdateFlags to property IDs
+		static PropertyIdSet updateFlagsToPropertyIds(int aUpdatedProperties) noexcept;
 	private:
 
 	};
@@ -56,13 +56,12 @@ namespace webserver {
 	}
 
 	api_return WebUserApi::handleGetUsers(ApiRequest& aRequest) {
-		auto j = Serializer::serializeItemList(WebUserUtils::propertyHandler, getUsers());
-		aRequest.setResponseBody(j);
+		aRequest.setResponseBodyRaw(Serializer::writeItemList(WebUserUtils::propertyHandler, getUsers()));
 		return http::status::ok;
 	}
 
 	WebUserPtr WebUserApi::parseUserNameParam(ApiRequest& aRequest) {
-		const auto& userName = aRequest.getStringParam(USERNAME_PARAM);
+		const auto userName = string(aRequest.getStringParam(USERNAME_PARAM));
 		auto user = um.getUser(userName);
 		if (!user) {
 			throw RequestException(http::status::not_found, "User " + userName + " was not found");
@@ -134,7 +133,7 @@ namespace webserver {
 	}
 
 	api_return WebUserApi::handleRemoveUser(ApiRequest& aRequest) {
-		const auto& userName = aRequest.getStringParam(USERNAME_PARAM);
+		const auto userName = string(aRequest.getStringParam(USERNAME_PARAM));
 		if (!um.removeUser(userName)) {
 			aRequest.setResponseErrorStr("User " + userName + " was not found");
 			return http::status::not_found;
@@ -152,7 +151,7 @@ namespace webserver {
 	}
 
 	void WebUserApi::on(WebUserManagerListener::UserUpdated, const WebUserPtr& aUser) noexcept {
-		view.onItemUpdated(aUser, toPropertyIdSet(WebUserUtils::properties));
+		view.onItemUpdated(aUser, WebUserUtils::propertyHandler.allProperties);
 
 		maybeSend("web_user_updated", [&] { 
 			return Serializer::serializeItem(aUser, WebUserUtils::propertyHandler); 
@@ -18,11 +18,16 @@
 
 #include "stdinc.h"
 
+#include <web-server/ApiRouter.h>
+#include <web-server/RateLimiter.h>
+#include <web-server/Session.h>
 #include <web-server/WebServerManager.h>
 #include <web-server/WebUserManager.h>
 
 #include <api/base/ApiModule.h>
 
+#include <chrono>
+
 namespace webserver {
 	ApiModule::ApiModule(Session* aSession) : session(aSession) {
 
@@ -32,55 +37,161 @@ namespace webserver {
 
 	}
 
-	optional<ApiRequest::NamedParamMap> ApiModule::RequestHandler::matchParams(const ApiRequest::PathTokenList& aPathTokens) const noexcept {
-		if (method == METHOD_FORWARD) {
-			if (aPathTokens.size() < params.size()) {
-				return nullopt;
+	bool ApiModule::RequestHandler::Param::matches(std::string_view aToken) const noexcept {
+		switch (type) {
+			case Type::EXACT: return aToken == id;
+			case Type::NUMBER: {
+				return !aToken.empty() && ranges::all_of(aToken, [](char c) {
+					return c >= '0' && c <= '9';
+				});
+			}
+			case Type::BASE32: {
+				return aToken.size() == 39 && ranges::all_of(aToken, [](char c) {
+					return (c >= '0' && c <= '9') || (c >= 'A' && c <= 'Z');
+				});
+			}
+			case Type::WORD: {
+				return !aToken.empty() && ranges::all_of(aToken, [](char c) {
+					return (c >= '0' && c <= '9') || (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || c == '_';
+				});
 			}
-		} else if (aPathTokens.size() != params.size()) {
-			return nullopt;
+			case Type::CUSTOM: return matchF(aToken);
 		}
 
-		for (auto i = 0; i < static_cast<int>(params.size()); i++) {
-			try {
-				if (!boost::regex_search(aPathTokens[i], params[i].reg)) {
-					return nullopt;
-				}
-			} catch (const std::runtime_error&) {
-				return nullopt;
+		return false;
+	}
+
+	bool ApiModule::RequestHandler::Param::hasSameMatcher(const Param& aOther) const noexcept {
+		if (type != aOther.type) {
+			return false;
+		}
+
+		if (type == Type::EXACT) {
+			return id == aOther.id;
+		}
+
+		return matchF == aOther.matchF;
+	}
+
+	ApiRequest::NamedParamList ApiModule::RequestHandler::getNamedParams(const ApiRequest::PathTokenList& aPathTokens) const noexcept {
+		ApiRequest::NamedParamList ret;
+		for (size_t i = 0; i < params.size(); i++) {
+			// The param count has been validated when the route was added
+			ret.add(params[i].id, aPathTokens[i], params[i].type == Param::Type::NUMBER);
+		}
+
+		return ret;
+	}
+
+	void ApiModule::RouteNode::addHandler(const RequestHandler& aHandler, size_t aHandlerIndex, size_t aParamPos) noexcept {
+		dcassert(aHandler.params.size() <= ApiRequest::NamedParamList::MAX_PARAMS);
+		if (aParamPos == aHandler.params.size()) {
+			if (aHandler.method == METHOD_FORWARD) {
+				forwardHandlers.push_back(aHandlerIndex);
+			} else {
+				handlers.push_back(aHandlerIndex);
+			}
+
+			return;
+		}
+
+		const auto& param = aHandler.params[aParamPos];
+		if (param.type == RequestHandler::Param::Type::EXACT) {
+			auto& child = exactChildren[param.id];
+			if (!child) {
+				child = make_unique<RouteNode>();
 			}
+
+			child->addHandler(aHandler, aHandlerIndex, aParamPos + 1);
+			return;
 		}
 
-		ApiRequest::NamedParamMap paramMap;
-		for (auto i = 0; i < static_cast<int>(params.size()); i++) {
-			paramMap[params[i].id] = aPathTokens[i];
+		auto i = ranges::find_if(paramChildren, [&param](const auto& aChild) {
+			return aChild.first.hasSameMatcher(param);
+		});
+
+		if (i == paramChildren.end()) {
+			paramChildren.emplace_back(param, make_unique<RouteNode>());
+			i = paramChildren.end() - 1;
 		}
 
-		return paramMap;
+		i->second->addHandler(aHandler, aHandlerIndex, aParamPos + 1);
 	}
 
-	api_return ApiModule::handleRequest(ApiRequest& aRequest) {
-		bool hasParamNameMatch = false; // for better error reporting
-
-		// Match parameters
-		auto handler = find_if(requestHandlers.begin(), requestHandlers.end(), [&](const RequestHandler& aHandler) {
-			// Regular matching
-			auto namedParams = aHandler.matchParams(aRequest.getPathTokens());
-			if (!namedParams) {
-				return false;
+	void ApiModule::RouteNode::matchMethod(const RequestHandlerList& aHandlers, const vector<size_t>& aHandlerIndexes, RequestMethod aMethod, Match& match_) noexcept {
+		if (aHandlerIndexes.empty()) {
+			return;
+		}
+
+		match_.pathMatched = true;
+
+		// Indexes are in the registration order
+		for (auto index: aHandlerIndexes) {
+			if (index >= match_.handlerIndex) {
+				break;
+			}
+
+			const auto& h = aHandlers[index];
+			if (h.method == aMethod || h.method == METHOD_FORWARD) {
+				match_.handlerIndex = index;
+				break;
 			}
+		}
+	}
+
+	void ApiModule::RouteNode::match(const RequestHandlerList& aHandlers, const ApiRequest::PathTokenList& aPathTokens, size_t aTokenPos, RequestMethod aMethod, Match& match_) const noexcept {
+		matchMethod(aHandlers, forwardHandlers, aMethod, match_);
+		if (aTokenPos == aPathTokens.size()) {
+			matchMethod(aHandlers, handlers, aMethod, match_);
+			return;
+		}
+
+		const auto token = aPathTokens[aTokenPos];
 
-			if (aHandler.method == aRequest.getMethod() || aHandler.method == METHOD_FORWARD) {
-				aRequest.setNamedParams(*namedParams);
-				return true;
+		auto exact = exactChildren.find(token);
+		if (exact != exactChildren.end()) {
+			exact->second->match(aHandlers, aPathTokens, aTokenPos + 1, aMethod, match_);
+		}
+
+		for (const auto& [param, child] : paramChildren) {
+			if (param.matches(token)) {
+				child->match(aHandlers, aPathTokens, aTokenPos + 1, aMethod, match_);
 			}
+		}
+	}
 
-			hasParamNameMatch = true;
-			return false;
+	string ApiModule::RequestHandler::getPattern() const noexcept {
+		string ret;
+		for (const auto& param: params) {
+			if (!ret.empty()) {
+				ret += '/';
+			}
+
+			ret += param.type == Param::Type::EXACT ? param.id : "{" + param.id + "}";
+		}
+
+		return ret;
+	}
+
+	const ApiModule::RouteNode& ApiModule::getRoutes() noexcept {
+		std::call_once(routesBuilt, [this] {
+			for (size_t i = 0; i < requestHandlers.size(); i++) {
+				routes.addHandler(requestHandlers[i], i);
+			}
+
+			handlerMetrics = make_unique<std::atomic<ApiMetrics::RouteMetrics*>[]>(requestHandlers.size());
 		});
 
-		if (handler == requestHandlers.end()) {
-			if (hasParamNameMatch) {
+		return routes;
+	}
+
+	api_return ApiModule::handleRequest(ApiRequest& aRequest) {
+		// Use the first added handler matching the path and supporting the method
+		RouteNode::Match match;
+		getRoutes().match(requestHandlers, aRequest.getPathTokens(), 0, aRequest.getMethod(), match);
+
+		if (match.handlerIndex == string::npos) {
+			if (match.pathMatched) {
 				aRequest.setResponseErrorStr("Method " + aRequest.getMethodStr() + " is not supported for this handler");
 				return http::status::method_not_allowed;
 			}
@@ -89,13 +200,122 @@ namespace webserver {
 			return http::status::bad_request;
 		}
 
+		const auto handlerIndex = match.handlerIndex;
+		const auto handler = &requestHandlers[handlerIndex];
+		aRequest.setNamedParams(handler->getNamedParams(aRequest.getPathTokens()));
+
 		// Check permission
 		if (!session->getUser()->hasPermission(handler->access)) {
 			aRequest.setResponseErrorStr("The permission " + WebUser::accessToString(handler->access) + " is required for accessing this method");
 			return http::status::forbidden;
 		}
 
-		return handler->f(aRequest);
+		// Forwarded requests are admitted by the final handler
+		// Extensions are trusted as they also handle the hooks and other requests initiated by the application
+		if (handler->method != METHOD_FORWARD && handler->cost > 0 && !aRequest.getAdmitted() && session->getSessionType() != Session::TYPE_EXTENSION) {
+			auto queueTime = session->getServer()->getRateLimiter().admit(session->getId(), session->getUser()->getUserName(), handler->cost);
+			if (!queueTime) {
+				aRequest.setResponseErrorStr("Too many requests");
+				return http::status::too_many_requests;
+			}
+
+			if (*queueTime > 0) {
+				return queueRequest(aRequest, *queueTime);
+			}
+		}
+
+		if (handler->method == METHOD_FORWARD) {
+			return handler->f(aRequest);
+		}
+
+		// Record the time until the request has been completed
+		auto metrics = &getHandlerMetrics(handlerIndex, aRequest);
+		const auto start = std::chrono::steady_clock::now();
+		const auto recordLatency = [metrics, start] {
+			const auto duration = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+			metrics->latency.record(static_cast<uint64_t>(duration.count()));
+		};
+
+		// Deferred requests are recorded when the completion function is called
+		aRequest.wrapDeferredHandler([recordLatency](ApiCompletionF&& aCompletionF) -> ApiCompletionF {
+			return [recordLatency, completionF = std::move(aCompletionF)](api_return aStatus, const json& aResponseJsonData, const json& aResponseErrorJson) {
+				recordLatency();
+				completionF(aStatus, aResponseJsonData, aResponseErrorJson);
+			};
+		});
+
+		api_return code;
+		try {
+			code = handler->f(aRequest);
+		} catch (...) {
+			recordLatency();
+			throw;
+		}
+
+		if (code != CODE_DEFERRED) {
+			recordLatency();
+		}
+
+		return code;
+	}
+
+	ApiMetrics::RouteMetrics& ApiModule::getHandlerMetrics(size_t aHandlerIndex, const ApiRequest& aRequest) noexcept {
+		auto& cached = handlerMetrics[aHandlerIndex];
+		auto metrics = cached.load(std::memory_order_acquire);
+		if (!metrics) {
+			// Concurrent lookups will receive the same instance
+			const auto& handler = requestHandlers[aHandlerIndex];
+			metrics = &session->getServer()->getMetrics().getRouteMetrics(string(aRequest.getApiModule()), aRequest.getMethodStr(), handler.getPattern());
+			cached.store(metrics, std::memory_order_release);
+		}
+
+		return *metrics;
+	}
+
+	api_return ApiModule::queueRequest(ApiRequest& aRequest, uint64_t aQueueTime) noexcept {
+		auto completionF = aRequest.defer();
+		auto task = [
+			completionF,
+			path = aRequest.getRequestPath(),
+			method = aRequest.getMethodStr(),
+			body = aRequest.getRequestBody(),
+			s = aRequest.getSession()
+		]() mutable {
+			bool isDeferred = false;
+			const auto deferredF = [&isDeferred, &completionF]() {
+				isDeferred = true;
+				return completionF;
+			};
+
+			// Run the request again from the beginning (the handler state may have changed in the meanwhile)
+			json output, error;
+			api_return code;
+			try {
+				ApiRequest apiRequest(path, method, std::move(body), s, deferredF, output, error);
+				apiRequest.setAdmitted(true);
+
+				RouterRequest routerRequest{ apiRequest, s->getSessionType() == Session::TYPE_SECURE, nullptr, s->getIp() };
+				code = ApiRouter::handleRequest(routerRequest);
+			} catch (const std::invalid_argument& e) {
+				completionF(http::status::bad_request, nullptr, ApiRequest::toResponseErrorStr(e.what()));
+				return;
+			}
+
+			if (!isDeferred) {
+				completionF(code, output, error);
+			}
+		};
+
+		// Run the request in the request thread pool so that handlers waiting for hooks won't block the task threads
+		const auto queueTime = static_cast<time_t>(aQueueTime);
+		if (const auto& delayedTaskHandler = aRequest.getDelayedTaskHandler()) {
+			delayedTaskHandler(std::move(task), queueTime);
+		} else {
+			auto server = session->getServer();
+			server->addDelayedRequestTask(server->createRequestStrand(), std::move(task), queueTime);
+		}
+
+		return CODE_DEFERRED;
 	}
 
 	TimerPtr ApiModule::getTimer(Callback&& aTask, time_t aIntervalMillis) {
@@ -22,32 +22,34 @@
 #include "forward.h"
 
 #include <web-server/Access.h>
+#include <web-server/ApiMetrics.h>
 #include <web-server/ApiRequest.h>
 
 #include <airdcpp/core/header/debug.h>
 
-namespace webserver {
-	using boost::regex;
+#include <mutex>
 
+namespace webserver {
 	class ApiModule {
 	public:
 #define MAX_COUNT "max_count_param"
 #define START_POS "start_pos_param"
 
-#define TTH_REG regex(R"(^[0-9A-Z]{39}$)")
-#define CID_REG TTH_REG
-#define TOKEN_REG regex(R"(^\d+$)")
+#define PARAM_TYPE ApiModule::RequestHandler::Param::Type
 
-#define NUM_PARAM(id) (ApiModule::RequestHandler::Param(id, TOKEN_REG))
+#define NUM_PARAM(id) (ApiModule::RequestHandler::Param(id, PARAM_TYPE::NUMBER))
 #define TOKEN_PARAM NUM_PARAM(TOKEN_PARAM_ID)
 #define RANGE_START_PARAM NUM_PARAM(START_POS)
 #define RANGE_MAX_PARAM NUM_PARAM(MAX_COUNT)
 
-#define TTH_PARAM (ApiModule::RequestHandler::Param(TTH_PARAM_ID, TTH_REG))
-#define CID_PARAM (ApiModule::RequestHandler::Param(CID_PARAM_ID, CID_REG))
+#define TTH_PARAM (ApiModule::RequestHandler::Param(TTH_PARAM_ID, PARAM_TYPE::BASE32))
+#define CID_PARAM (ApiModule::RequestHandler::Param(CID_PARAM_ID, PARAM_TYPE::BASE32))
+
+#define STR_PARAM(id) (ApiModule::RequestHandler::Param(id, PARAM_TYPE::WORD))
+#define EXACT_PARAM(pattern) (ApiModule::RequestHandler::Param(pattern, PARAM_TYPE::EXACT))
 
-#define STR_PARAM(id) (ApiModule::RequestHandler::Param(id, regex(R"(^\w+$)")))
-#define EXACT_PARAM(pattern) (ApiModule::RequestHandler::Param(pattern, regex("^" + string(pattern) + "$")))
+// Param with a custom matcher function (bool (std::string_view aToken) noexcept)
+#define CUSTOM_PARAM(id, matcher) (ApiModule::RequestHandler::Param(id, PARAM_TYPE::CUSTOM, matcher))
 
 #define BRACED_INIT_LIST(...) {__VA_ARGS__}
 
@@ -68,6 +70,9 @@ namespace webserver {
 // Regular handler for the current module with a module handler method
 #define METHOD_HANDLER(access, method, params, func) MODULE_METHOD_HANDLER(this, access, method, params, func)
 
+// Regular handler with a custom rate limiter cost (handlers with cost > 1 are throttled as bulk requests, handlers with cost 0 aren't throttled)
+#define METHOD_HANDLER_COST(access, method, params, func, cost) (this->getRequestHandlers().push_back(ApiModule::RequestHandler(access, method, BRACED_INIT_LIST params, std::bind_front(&func, this), cost)))
+
 // Handler is bound to a custom variable
 #define VARIABLE_METHOD_HANDLER(access, method, params, func, bound) MODULE_METHOD_HANDLER_BOUND(this, access, method, params, func, bound)
 
@@ -76,10 +81,28 @@ namespace webserver {
 
 		struct RequestHandler {
 			struct Param {
-				Param(string aParamId, regex&& aReg) : id(std::move(aParamId)), reg(std::move(aReg)) { }
+				enum class Type {
+					EXACT, // The ID must match the token
+					NUMBER, // Unsigned integer
+					BASE32, // TTH or CID
+					WORD, // Alphanumeric characters and underscores
+					CUSTOM, // Matched with the supplied function
+				};
+
+				using MatchF = bool (*)(std::string_view aToken) noexcept;
+
+				Param(string aParamId, Type aType, MatchF aMatchF = nullptr) : id(std::move(aParamId)), type(aType), matchF(aMatchF) {
+					dcassert((type == Type::CUSTOM) == !!matchF);
+				}
 
 				string id;
-				regex reg;
+				Type type;
+				MatchF matchF;
+
+				bool matches(std::string_view aToken) const noexcept;
+
+				// Whether both params accept the same tokens
+				bool hasSameMatcher(const Param& aOther) const noexcept;
 			};
 
 			using ParamList = vector<Param>;
@@ -87,8 +110,8 @@ namespace webserver {
 			using HandlerFunction = std::function<api_return (ApiRequest &)>;
 
 			// Regular handler
-			RequestHandler(Access aAccess, RequestMethod aMethod, ParamList&& aParams, HandlerFunction&& aFunction) :
-				method(aMethod), params(std::move(aParams)), f(std::move(aFunction)), access(aAccess) {
+			RequestHandler(Access aAccess, RequestMethod aMethod, ParamList&& aParams, HandlerFunction&& aFunction, int aCost = 1) :
+				method(aMethod), params(std::move(aParams)), f(std::move(aFunction)), access(aAccess), cost(aCost) {
 			
 			}
 
@@ -97,11 +120,44 @@ namespace webserver {
 			const HandlerFunction f;
 			const Access access;
 
-			optional<ApiRequest::NamedParamMap> matchParams(const ApiRequest::PathTokenList& aPathTokens) const noexcept;
+			// Tokens consumed from the rate limiter buckets
+			const int cost;
+
+			ApiRequest::NamedParamList getNamedParams(const ApiRequest::PathTokenList& aPathTokens) const noexcept;
+
+			// Path pattern for metrics (e.g. "bundles/{id_param}/search")
+			string getPattern() const noexcept;
 		};
 
 		using RequestHandlerList = std::vector<RequestHandler>;
 
+		// Path segment trie for finding the handlers matching the request path
+		class RouteNode {
+		public:
+			void addHandler(const RequestHandler& aHandler, size_t aHandlerIndex, size_t aParamPos = 0) noexcept;
+
+			struct Match {
+				// First added handler matching both the path and the method
+				size_t handlerIndex = string::npos;
+
+				// Whether any handler matched the path (regardless of the method)
+				bool pathMatched = false;
+			};
+
+			void match(const RequestHandlerList& aHandlers, const ApiRequest::PathTokenList& aPathTokens, size_t aTokenPos, RequestMethod aMethod, Match& match_) const noexcept;
+		private:
+			static void matchMethod(const RequestHandlerList& aHandlers, const vector<size_t>& aHandlerIndexes, RequestMethod aMethod, Match& match_) noexcept;
+
+			// Handlers whose path ends at this node
+			vector<size_t> handlers;
+
+			// Forward handlers accept any remaining path tokens
+			vector<size_t> forwardHandlers;
+
+			std::map<string, unique_ptr<RouteNode>, std::less<>> exactChildren;
+			vector<pair<RequestHandler::Param, unique_ptr<RouteNode>>> paramChildren;
+		};
+
 		api_return handleRequest(ApiRequest& aRequest);
 
 		ApiModule(ApiModule&) = delete;
@@ -127,6 +183,20 @@ namespace webserver {
 		Session* session;
 
 		RequestHandlerList requestHandlers;
+	private:
+		// Built on the first request (all handlers have been added by the constructors at that point)
+		const RouteNode& getRoutes() noexcept;
+
+		// Handle the request after the queue time set by the rate limiter
+		api_return queueRequest(ApiRequest& aRequest, uint64_t aQueueTime) noexcept;
+
+		ApiMetrics::RouteMetrics& getHandlerMetrics(size_t aHandlerIndex, const ApiRequest& aRequest) noexcept;
+
+		// Cached metrics by handler index (allocated when the routes are built)
+		unique_ptr<std::atomic<ApiMetrics::RouteMetrics*>[]> handlerMetrics;
+
+		RouteNode routes;
+		std::once_flag routesBuilt;
 	};
 
 	using HandlerPtr = std::unique_ptr<ApiModule>;
@@ -50,12 +50,12 @@ namespace webserver {
 
 			METHOD_HANDLER(aHookAccess, METHOD_POST, (EXACT_PARAM("hooks"), STR_PARAM(LISTENER_PARAM_ID)), Type::handleSubscribeHook);
 
-			METHOD_HANDLER(aHookAccess, METHOD_POST, (EXACT_PARAM("hooks"), STR_PARAM(LISTENER_PARAM_ID), FILTERABLE_LISTENER_ENTITY_ID_PARAM, TOKEN_PARAM, EXACT_PARAM("resolve")), Type::handleResolveHookAction);
-			METHOD_HANDLER(aHookAccess, METHOD_POST, (EXACT_PARAM("hooks"), STR_PARAM(LISTENER_PARAM_ID), FILTERABLE_LISTENER_ENTITY_ID_PARAM, TOKEN_PARAM, EXACT_PARAM("reject")), Type::handleRejectHookAction);
+			METHOD_HANDLER_COST(aHookAccess, METHOD_POST, (EXACT_PARAM("hooks"), STR_PARAM(LISTENER_PARAM_ID), FILTERABLE_LISTENER_ENTITY_ID_PARAM, TOKEN_PARAM, EXACT_PARAM("resolve")), Type::handleResolveHookAction, 0);
+			METHOD_HANDLER_COST(aHookAccess, METHOD_POST, (EXACT_PARAM("hooks"), STR_PARAM(LISTENER_PARAM_ID), FILTERABLE_LISTENER_ENTITY_ID_PARAM, TOKEN_PARAM, EXACT_PARAM("reject")), Type::handleRejectHookAction, 0);
 		}
 
 		api_return handleSubscribeHook(ApiRequest& aRequest) {
-			const auto& subscription = aRequest.getStringParam(LISTENER_PARAM_ID);
+			const auto subscription = string(aRequest.getStringParam(LISTENER_PARAM_ID));
 			if (BaseType::hasEntitySubscribers(subscription)) {
 				throw RequestException(http::status::conflict, "Global hook subscription can't be added while ID-specific subscriptions are active");
 			}
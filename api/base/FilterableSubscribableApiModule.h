@@ -79,7 +79,7 @@ namespace webserver {
 
 	protected:
 		api_return handleSubscribe(ApiRequest& aRequest) override {
-			const auto& subscription = aRequest.getStringParam(LISTENER_PARAM_ID);
+			const auto subscription = string(aRequest.getStringParam(LISTENER_PARAM_ID));
 			if (hasEntitySubscribers(subscription)) {
 				throw RequestException(http::status::conflict, "Global listener can't be added while ID-specific subscriptions are active");
 			}
@@ -87,12 +87,12 @@ namespace webserver {
 			return BaseType::handleSubscribe(aRequest);
 		}
 
-		const string& parseFilterableSubscription(ApiRequest& aRequest) {
+		string parseFilterableSubscription(ApiRequest& aRequest) {
 			if (!BaseType::getSocket()) {
 				throw RequestException(http::status::precondition_required, "Socket required");
 			}
 
-			const auto& subscription = aRequest.getStringParam(LISTENER_PARAM_ID);
+			auto subscription = string(aRequest.getStringParam(LISTENER_PARAM_ID));
 			if (!filterableSubscriptionExists(subscription)) {
 				throw RequestException(http::status::not_found, "No such filterable subscription: " + subscription);
 			}
@@ -112,8 +112,7 @@ namespace webserver {
 		}
 
 		const IdType parseEntityIdParam(ApiRequest& aRequest) {
-			const auto& entityId = aRequest.getStringParam(FILTERABLE_LISTENER_ENTITY_ID);
-			return idDeserializer(entityId);
+			return idDeserializer(string(aRequest.getStringParam(FILTERABLE_LISTENER_ENTITY_ID)));
 		}
 
 		virtual api_return handleSubscribeEntity(ApiRequest& aRequest) {
@@ -117,7 +117,7 @@ namespace webserver {
 
 		// Parse module ID from the request, throws if the module was not found
 		typename ItemType::Ptr getSubModule(ApiRequest& aRequest) {
-			const auto& id = aRequest.getStringParam(paramId);
+			const auto id = string(aRequest.getStringParam(paramId));
 
 			auto sub = findSubModule(idConvertF(id));
 			if (!sub) {
@@ -200,6 +200,10 @@ namespace webserver {
 			});
 		}
 
+		bool sendSerialized(const string& aSubscription, const string& aData) override {
+			return SubscribableApiModule::sendSerialized(aSubscription, aData, jsonId);
+		}
+
 		bool maybeSend(const string& aSubscription, const SubscribableApiModule::JsonCallback& aCallback) override {
 			if (!subscriptionActive(aSubscription)) {
 				return false;
@@ -54,8 +54,8 @@ namespace webserver {
 		// VARIABLE_METHOD_HANDLER(aHookAccess, METHOD_POST, (EXACT_PARAM("hook_actions"), TOKEN_PARAM, EXACT_PARAM("resolve")), HookActionHandler::handleResolveHookAction, actionHandler);
 		// VARIABLE_METHOD_HANDLER(aHookAccess, METHOD_POST, (EXACT_PARAM("hook_actions"), TOKEN_PARAM, EXACT_PARAM("reject")), HookActionHandler::handleRejectHookAction, actionHandler);
 
-		METHOD_HANDLER(aHookAccess, METHOD_POST, (EXACT_PARAM("hooks"), STR_PARAM(LISTENER_PARAM_ID), TOKEN_PARAM, EXACT_PARAM("resolve")), HookApiModule::handleResolveHookAction);
-		METHOD_HANDLER(aHookAccess, METHOD_POST, (EXACT_PARAM("hooks"), STR_PARAM(LISTENER_PARAM_ID), TOKEN_PARAM, EXACT_PARAM("reject")), HookApiModule::handleRejectHookAction);
+		METHOD_HANDLER_COST(aHookAccess, METHOD_POST, (EXACT_PARAM("hooks"), STR_PARAM(LISTENER_PARAM_ID), TOKEN_PARAM, EXACT_PARAM("resolve")), HookApiModule::handleResolveHookAction, 0);
+		METHOD_HANDLER_COST(aHookAccess, METHOD_POST, (EXACT_PARAM("hooks"), STR_PARAM(LISTENER_PARAM_ID), TOKEN_PARAM, EXACT_PARAM("reject")), HookApiModule::handleRejectHookAction, 0);
 	}
 
 	api_return HookApiModule::handleResolveHookAction(ApiRequest& aRequest) {
@@ -89,7 +89,7 @@ namespace webserver {
 			throw RequestException(http::status::precondition_required, "Socket required");
 		}
 
-		const auto& hook = aRequest.getStringParam(LISTENER_PARAM_ID);
+		const auto hook = string(aRequest.getStringParam(LISTENER_PARAM_ID));
 		auto i = hooks.find(hook);
 		if (i == hooks.end()) {
 			throw RequestException(http::status::not_found, "No such hook: " + hook);
@@ -18,6 +18,8 @@
 
 #include "stdinc.h"
 
+#include <web-server/EventBus.h>
+#include <web-server/JsonWriter.h>
 #include <web-server/SocketManager.h>
 #include <web-server/WebSocket.h>
 #include <web-server/Session.h>
@@ -27,19 +29,35 @@
 
 namespace webserver {
 	SubscribableApiModule::SubscribableApiModule(Session* aSession, Access aSubscriptionAccess) : ApiModule(aSession), subscriptionAccess(aSubscriptionAccess) {
-		socket = aSession->getServer()->getSocketManager().getSocket(aSession->getId());
-
 		aSession->addListener(this);
 
+		{
+			// Read the socket only after the listener has been added so that a socket connected meanwhile won't be missed
+			// (SocketManager updates the socket of the session before firing the socket events)
+			Lock l(socketCS);
+			socket = aSession->getServer()->getSocketManager().getSocket(aSession->getId());
+		}
+
 		METHOD_HANDLER(aSubscriptionAccess, METHOD_POST, (EXACT_PARAM("listeners"), STR_PARAM(LISTENER_PARAM_ID)), SubscribableApiModule::handleSubscribe);
 		METHOD_HANDLER(aSubscriptionAccess, METHOD_DELETE, (EXACT_PARAM("listeners"), STR_PARAM(LISTENER_PARAM_ID)), SubscribableApiModule::handleUnsubscribe);
 	}
 
 	SubscribableApiModule::~SubscribableApiModule() {
 		session->removeListener(this);
+
+		for (const auto& subscription: sharedSubscriptions) {
+			setSharedSubscriptionState(subscription, false);
+		}
+
+		Lock l(socketCS);
 		socket = nullptr;
 	}
 
+	WebSocketPtr SubscribableApiModule::getSocket() const noexcept {
+		Lock l(socketCS);
+		return socket;
+	}
+
 	void SubscribableApiModule::createSubscriptions(const StringList& aSubscriptions) noexcept {
 		for (const auto& s : aSubscriptions) {
 			createSubscription(s);
@@ -51,7 +69,31 @@ namespace webserver {
 		subscriptions.emplace(aSubscription, false);
 	}
 
+	void SubscribableApiModule::createSharedSubscriptions(const StringList& aSubscriptions) noexcept {
+		for (const auto& s : aSubscriptions) {
+			createSubscription(s);
+			sharedSubscriptions.insert(s);
+		}
+	}
+
+	void SubscribableApiModule::setSubscriptionState(const string& aSubscription, bool aActive) noexcept {
+		subscriptions[aSubscription] = aActive;
+		if (sharedSubscriptions.contains(aSubscription)) {
+			setSharedSubscriptionState(aSubscription, aActive);
+		}
+	}
+
+	void SubscribableApiModule::setSharedSubscriptionState(const string& aSubscription, bool aActive) noexcept {
+		auto& eventBus = session->getServer()->getEventBus();
+		if (aActive) {
+			eventBus.subscribe(aSubscription, this);
+		} else {
+			eventBus.unsubscribe(aSubscription, this);
+		}
+	}
+
 	void SubscribableApiModule::on(SessionListener::SocketConnected, const WebSocketPtr& aSocket) noexcept {
+		Lock l(socketCS);
 		socket = aSocket;
 	}
 
@@ -61,15 +103,20 @@ namespace webserver {
 			enabled = false;
 		}
 
+		for (const auto& subscription: sharedSubscriptions) {
+			setSharedSubscriptionState(subscription, false);
+		}
+
+		Lock l(socketCS);
 		socket = nullptr;
 	}
 
-	const string& SubscribableApiModule::parseSubscription(ApiRequest& aRequest) {
-		if (!socket) {
+	string SubscribableApiModule::parseSubscription(ApiRequest& aRequest) {
+		if (!getSocket()) {
 			throw RequestException(http::status::precondition_required, "Socket required");
 		}
 
-		const auto& subscription = aRequest.getStringParam(LISTENER_PARAM_ID);
+		auto subscription = string(aRequest.getStringParam(LISTENER_PARAM_ID));
 		if (!subscriptionExists(subscription)) {
 			throw RequestException(http::status::not_found, "No such subscription: " + subscription);
 		}
@@ -89,15 +136,42 @@ namespace webserver {
 		return http::status::no_content;
 	}
 
+	WsMessageInfo SubscribableApiModule::getEventMessageInfo(const json& aJson) noexcept {
+		WsMessageInfo info;
+
+		// Tick events contain the full item so only the latest one needs to be delivered
+		// Other events (e.g. added/removed items and list view deltas) must never be dropped as the client state would diverge
+		auto event = aJson.find("event");
+		if (event != aJson.end() && event->is_string() && event->get_ref<const string&>().ends_with("_tick")) {
+			info.droppable = true;
+			info.supersedeKey = event->get<string>();
+
+			auto entityId = aJson.find("id");
+			if (entityId != aJson.end()) {
+				info.supersedeKey += "/" + entityId->dump();
+			}
+
+			auto data = aJson.find("data");
+			if (data != aJson.end() && data->is_object()) {
+				auto itemId = data->find("id");
+				if (itemId != data->end()) {
+					info.supersedeKey += "/" + itemId->dump();
+				}
+			}
+		}
+
+		return info;
+	}
+
 	bool SubscribableApiModule::send(const json& aJson) {
 		// Ensure that the socket won't be deleted while sending the message...
-		auto s = socket;
+		auto s = getSocket();
 		if (!s) {
 			return false;
 		}
 
 		try {
-			s->sendPlain(aJson);
+			s->sendPlain(aJson, getEventMessageInfo(aJson));
 		} catch (const json::exception&) {
 			// Ignore JSON errors...
 			return false;
@@ -113,6 +187,37 @@ namespace webserver {
 		});
 	}
 
+	bool SubscribableApiModule::sendSerialized(const string& aSubscription, const string& aData) {
+		return sendSerialized(aSubscription, aData, nullptr);
+	}
+
+	bool SubscribableApiModule::sendSerialized(const string& aSubscription, const string& aData, const json& aEntityId) {
+		auto s = getSocket();
+		if (!s) {
+			return false;
+		}
+
+		// Tick events would need to be parsed for the supersede key
+		dcassert(!aSubscription.ends_with("_tick"));
+
+		string message;
+		message.reserve(aData.size() + aSubscription.size() + 32);
+
+		JsonWriter writer(message);
+		writer.startObject();
+		writer.key("data");
+		writer.rawValue(aData);
+		writer.field("event", aSubscription);
+		if (!aEntityId.is_null()) {
+			writer.field("id", aEntityId);
+		}
+		writer.endObject();
+
+		// Not a tick event so it must be delivered
+		s->sendText(std::move(message), WsMessageInfo());
+		return true;
+	}
+
 	bool SubscribableApiModule::maybeSend(const string& aSubscription, const JsonCallback& aCallback) {
 		if (!subscriptionActive(aSubscription)) {
 			return false;
@@ -21,10 +21,13 @@
 
 #include "forward.h"
 
+#include <web-server/IServerEndpoint.h>
 #include <web-server/SessionListener.h>
 
 #include <api/base/ApiModule.h>
 
+#include <airdcpp/core/thread/CriticalSection.h>
+
 namespace webserver {
 	class WebSocket;
 #define LISTENER_PARAM_ID "listener_param"
@@ -37,15 +40,20 @@ namespace webserver {
 
 		virtual void createSubscriptions(const StringList& aSubscriptions) noexcept;
 
+		// Shared subscriptions receive the events from the server event bus (the module won't send them itself)
+		void createSharedSubscriptions(const StringList& aSubscriptions) noexcept;
+
 		virtual bool send(const json& aJson);
 		virtual bool send(const string& aSubscription, const json& aJson);
 
+		// Send event data that has been serialized already (e.g. with JsonWriter)
+		// Use send with json data for sockets with a binary message format (the serialized data would have to be parsed)
+		virtual bool sendSerialized(const string& aSubscription, const string& aData);
+
 		using JsonCallback = std::function<json ()>;
 		virtual bool maybeSend(const string& aSubscription, const JsonCallback& aCallback);
 
-		virtual void setSubscriptionState(const string& aSubscription, bool aActive) noexcept {
-			subscriptions[aSubscription] = aActive;
-		}
+		virtual void setSubscriptionState(const string& aSubscription, bool aActive) noexcept;
 
 		virtual bool subscriptionActive(const string& aSubscription) const noexcept {
 			auto s = subscriptions.find(aSubscription);
@@ -62,12 +70,15 @@ namespace webserver {
 			return subscriptionAccess;
 		}
 
-		const WebSocketPtr& getSocket() const noexcept {
-			return socket;
-		}
+		WebSocketPtr getSocket() const noexcept;
+
+		static WsMessageInfo getEventMessageInfo(const json& aJson) noexcept;
 	protected:
 		void createSubscription(const string& aSubscription) noexcept;
 
+		// Entity ID is included in the event if it's set
+		bool sendSerialized(const string& aSubscription, const string& aData, const json& aEntityId);
+
 		void on(SessionListener::SocketConnected, const WebSocketPtr&) noexcept override;
 		void on(SessionListener::SocketDisconnected) noexcept override;
 
@@ -76,10 +87,15 @@ namespace webserver {
 		virtual api_return handleSubscribe(ApiRequest& aRequest);
 		virtual api_return handleUnsubscribe(ApiRequest& aRequest);
 
-		virtual const string& parseSubscription(ApiRequest& aRequest);
+		virtual string parseSubscription(ApiRequest& aRequest);
 	private:
+		void setSharedSubscriptionState(const string& aSubscription, bool aActive) noexcept;
+
+		// Modules may be created in the task threads while the socket is being connected
+		mutable CriticalSection socketCS;
 		WebSocketPtr socket = nullptr;
 		SubscriptionMap subscriptions;
+		StringSet sharedSubscriptions;
 	};
 
 	using HandlerPtr = std::unique_ptr<ApiModule>;
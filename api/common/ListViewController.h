@@ -24,6 +24,7 @@
 #include <web-server/SessionListener.h>
 #include <web-server/Timer.h>
 #include <web-server/WebServerManager.h>
+#include <web-server/WebSocket.h>
 
 #include <airdcpp/core/timer/TimerManager.h>
 
@@ -36,6 +37,7 @@ namespace webserver {
 
 	template<class T, int PropertyCount>
 	class ListViewController : private SessionListener {
+		static_assert(PropertyCount <= PropertyIdSet::MAX_PROPERTIES, "Too many properties for PropertyIdSet");
 	public:
 		using ItemList = typename PropertyItemHandler<T>::ItemList;
 		using ItemListF = typename PropertyItemHandler<T>::ItemListFunction;
@@ -359,12 +361,116 @@ namespace webserver {
 			stop();
 		}
 
-		void sendJson(const json& j) {
-			if (j.is_null()) {
+		// Changed view properties to send to the client
+		struct ViewUpdate {
+			// Items in the new viewport (properties are nullptr for items that only need their position to be sent)
+			std::vector<std::pair<T, const PropertyIdSet*>> items;
+			bool hasItems = false;
+
+			std::optional<int> rangeOffset;
+			std::optional<int> rangeStart;
+			std::optional<int> matchingItems;
+			std::optional<int> totalItems;
+
+			bool empty() const noexcept {
+				return !hasItems && !rangeOffset && !rangeStart && !matchingItems && !totalItems;
+			}
+		};
+
+		void sendUpdate(const ViewUpdate& aUpdate) {
+			// Nothing has changed?
+			if (aUpdate.empty()) {
 				return;
 			}
 
-			apiModule->send(viewName + "_updated", j);
+			auto socket = apiModule->getSocket();
+			if (!socket) {
+				return;
+			}
+
+			if (socket->getMessageFormat() != MessageFormat::FORMAT_JSON) {
+				// Serialized JSON would have to be parsed before it can be converted to the binary format
+				apiModule->send(viewName + "_updated", serializeUpdate(aUpdate));
+				return;
+			}
+
+			string output;
+			JsonWriter writer(output);
+			writeUpdate(aUpdate, writer);
+			apiModule->sendSerialized(viewName + "_updated", output);
+		}
+
+		void writeUpdate(const ViewUpdate& aUpdate, JsonWriter& writer_) const {
+			writer_.startObject();
+			if (aUpdate.hasItems) {
+				writer_.key("items");
+				writer_.startArray();
+				for (const auto& [item, propertyIds] : aUpdate.items) {
+					if (propertyIds) {
+						appendItemPartial(item, writer_, *propertyIds);
+					} else {
+						appendItemPosition(item, writer_);
+					}
+				}
+				writer_.endArray();
+			}
+
+			if (aUpdate.rangeOffset) {
+				writer_.field("range_offset", *aUpdate.rangeOffset);
+			}
+
+			if (aUpdate.rangeStart) {
+				writer_.field("range_start", *aUpdate.rangeStart);
+			}
+
+			if (aUpdate.matchingItems) {
+				writer_.field("matching_items", *aUpdate.matchingItems);
+			}
+
+			if (aUpdate.totalItems) {
+				writer_.field("total_items", *aUpdate.totalItems);
+			}
+
+			writer_.endObject();
+		}
+
+		json serializeUpdate(const ViewUpdate& aUpdate) const {
+			auto j = json::object();
+			if (aUpdate.hasItems) {
+				auto items = json::array();
+				for (const auto& [item, propertyIds] : aUpdate.items) {
+					json itemJson = {
+						{ "id", item->getToken() },
+					};
+
+					if (propertyIds) {
+						auto properties = Serializer::serializeProperties(item, itemHandler, *propertyIds);
+						itemJson["properties"] = properties.is_null() ? json::object() : std::move(properties);
+					}
+
+					items.push_back(std::move(itemJson));
+				}
+
+				j["items"] = std::move(items);
+			}
+
+			if (aUpdate.rangeOffset) {
+				j["range_offset"] = *aUpdate.rangeOffset;
+			}
+
+			if (aUpdate.rangeStart) {
+				j["range_start"] = *aUpdate.rangeStart;
+			}
+
+			if (aUpdate.matchingItems) {
+				j["matching_items"] = *aUpdate.matchingItems;
+			}
+
+			if (aUpdate.totalItems) {
+				j["total_items"] = *aUpdate.totalItems;
+			}
+
+			return j;
 		}
 
 		int initItems() {
@@ -440,11 +546,7 @@ namespace webserver {
 				matchingItemsCopy = matchingItems;
 			}
 
-			auto j = Serializer::serializeFromPosition(start, end - start, matchingItemsCopy, [this](const T& i) {
-				return Serializer::serializeItem(i, itemHandler);
-			});
-
-			aRequest.setResponseBody(j);
+			aRequest.setResponseBodyRaw(Serializer::writeItemList(start, end - start, itemHandler, matchingItemsCopy));
 			return http::status::ok;
 		}
 
@@ -500,7 +602,7 @@ namespace webserver {
 			// Start position
 			auto newStart = updateValues[IntCollector::TYPE_RANGE_START];
 
-			json j;
+			ViewUpdate update;
 
 			// Go through the tasks
 			auto updatedItems = handleTasks(currentTasks, sortProperty, sortAscending, newStart);
@@ -508,15 +610,15 @@ namespace webserver {
 			ItemList nextViewportItems;
 			if (newStart >= 0) {
 				// Get the new visible items
-				updateViewItems(updatedItems, j, newStart, updateValues[IntCollector::TYPE_MAX_COUNT], nextViewportItems);
+				updateViewItems(updatedItems, update, newStart, updateValues[IntCollector::TYPE_MAX_COUNT], nextViewportItems);
 
 				// Append other changed properties
 				auto startOffset = newStart - updateValues[IntCollector::TYPE_RANGE_START];
 				if (startOffset != 0) {
-					j["range_offset"] = startOffset;
+					update.rangeOffset = startOffset;
 				}
 
-				j["range_start"] = newStart;
+				update.rangeStart = newStart;
 			}
 
 			{
@@ -535,9 +637,9 @@ namespace webserver {
 			}
 
 			// Counts should be updated even if the list doesn't have valid settings posted
-			appendItemCounts(j);
+			appendItemCounts(update);
 
-			sendJson(j);
+			sendUpdate(update);
 		}
 
 		using ItemPropertyIdMap = std::map<T, const PropertyIdSet &>;
@@ -565,7 +667,7 @@ namespace webserver {
 			return updatedItems;
 		}
 
-		void updateViewItems(const ItemPropertyIdMap& aUpdatedItems, json& json_, int& newStart_, int aMaxCount, ItemList& nextViewportItems_) {
+		void updateViewItems(const ItemPropertyIdMap& aUpdatedItems, ViewUpdate& update_, int& newStart_, int aMaxCount, ItemList& nextViewportItems_) {
 			// Get the new visible items
 			ItemList currentItemsCopy;
 			{
@@ -590,24 +692,21 @@ namespace webserver {
 				currentItemsCopy = currentViewportItems;
 			}
 
-			json_["items"] = json::array();
+			update_.hasItems = true;
 
 			// List items
-			int pos = 0;
 			for (const auto& item : nextViewportItems_) {
 				if (!isInList(item, currentItemsCopy)) {
-					appendItemFull(item, json_, pos);
+					update_.items.emplace_back(item, &itemHandler.allProperties);
 				} else {
 					// append position
 					auto props = aUpdatedItems.find(item);
 					if (props != aUpdatedItems.end()) {
-						appendItemPartial(item, json_, pos, props->second);
+						update_.items.emplace_back(item, &props->second);
 					} else {
-						appendItemPosition(item, json_, pos);
+						update_.items.emplace_back(item, nullptr);
 					}
 				}
-
-				pos++;
 			}
 		}
 
@@ -638,7 +737,7 @@ namespace webserver {
 			}
 		}
 
-		void appendItemCounts(json& json_) {
+		void appendItemCounts(ViewUpdate& update_) {
 			int matchingItemCount = 0, totalItemCount = 0;
 
 			{
@@ -649,12 +748,12 @@ namespace webserver {
 
 			if (matchingItemCount != prevMatchingItemCount) {
 				prevMatchingItemCount = matchingItemCount;
-				json_["matching_items"] = matchingItemCount;
+				update_.matchingItems = matchingItemCount;
 			}
 
 			if (totalItemCount != prevTotalItemCount) {
 				prevTotalItemCount = totalItemCount;
-				json_["total_items"] = totalItemCount;
+				update_.totalItems = totalItemCount;
 			}
 		}
 
@@ -764,20 +863,24 @@ namespace webserver {
 
 		// JSON APPEND START
 
-		// Append item with all property values
-		void appendItemFull(const T& aItem, json& json_, int pos) {
-			appendItemPartial(aItem, json_, pos, toPropertyIdSet(itemHandler.properties));
-		}
-
 		// Append item with supplied property values
-		void appendItemPartial(const T& aItem, json& json_, int pos, const PropertyIdSet& aPropertyIds) {
-			appendItemPosition(aItem, json_, pos);
-			json_["items"][pos]["properties"] = Serializer::serializeProperties(aItem, itemHandler, aPropertyIds);
+		void appendItemPartial(const T& aItem, JsonWriter& writer_, const PropertyIdSet& aPropertyIds) const {
+			writer_.startObject();
+			writer_.field("id", aItem->getToken());
+
+			writer_.key("properties");
+			writer_.startObject();
+			Serializer::writeProperties(aItem, itemHandler, aPropertyIds, writer_);
+			writer_.endObject();
+
+			writer_.endObject();
 		}
 
 		// Append item without property values
-		static void appendItemPosition(const T& aItem, json& json_, int pos) {
-			json_["items"][pos]["id"] = aItem->getToken();
+		static void appendItemPosition(const T& aItem, JsonWriter& writer_) {
+			writer_.startObject();
+			writer_.field("id", aItem->getToken());
+			writer_.endObject();
 		}
 
 		// List of dynamically set filters
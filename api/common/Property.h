@@ -19,6 +19,11 @@
 #ifndef DCPP_PROPERTY_H
 #define DCPP_PROPERTY_H
 
+#include <web-server/JsonWriter.h>
+
+#include <bit>
+#include <initializer_list>
+
 #include <airdcpp/util/text/StringMatch.h>
 
 namespace webserver {
@@ -58,7 +63,102 @@ namespace webserver {
 
 	using PropertyList = vector<Property>;
 
-	using PropertyIdSet = std::set<int>;
+	// Set of property IDs stored as a bitmask (no allocations are needed when passing property sets around)
+	// Iteration happens in ascending order of IDs
+	class PropertyIdSet {
+	public:
+		static constexpr int MAX_PROPERTIES = 64;
+
+		class const_iterator {
+		public:
+			using iterator_category = std::forward_iterator_tag;
+			using value_type = int;
+			using difference_type = std::ptrdiff_t;
+			using pointer = const int*;
+			using reference = int;
+
+			constexpr const_iterator() noexcept = default;
+			constexpr explicit const_iterator(uint64_t aBits) noexcept : bits(aBits) { }
+
+			constexpr int operator*() const noexcept {
+				return std::countr_zero(bits);
+			}
+
+			constexpr const_iterator& operator++() noexcept {
+				// Clear the lowest set bit
+				bits &= bits - 1;
+				return *this;
+			}
+
+			constexpr const_iterator operator++(int) noexcept {
+				auto ret = *this;
+				++(*this);
+				return ret;
+			}
+
+			constexpr bool operator==(const const_iterator& aOther) const noexcept = default;
+		private:
+			uint64_t bits = 0;
+		};
+
+		using iterator = const_iterator;
+
+		constexpr PropertyIdSet() noexcept = default;
+		PropertyIdSet(std::initializer_list<int> aIds) noexcept {
+			for (auto id : aIds)
+				insert(id);
+		}
+
+		void insert(int aId) noexcept {
+			dcassert(aId >= 0 && aId < MAX_PROPERTIES);
+			bits |= toBit(aId);
+		}
+
+		// Merge all IDs from another set
+		constexpr void insert(const PropertyIdSet& aOther) noexcept {
+			bits |= aOther.bits;
+		}
+
+		constexpr void erase(int aId) noexcept {
+			bits &= ~toBit(aId);
+		}
+
+		constexpr bool contains(int aId) const noexcept {
+			return aId >= 0 && aId < MAX_PROPERTIES && (bits & toBit(aId)) != 0;
+		}
+
+		constexpr bool empty() const noexcept {
+			return bits == 0;
+		}
+
+		constexpr size_t size() const noexcept {
+			return static_cast<size_t>(std::popcount(bits));
+		}
+
+		constexpr void clear() noexcept {
+			bits = 0;
+		}
+
+		constexpr void swap(PropertyIdSet& aOther) noexcept {
+			std::swap(bits, aOther.bits);
+		}
+
+		constexpr const_iterator begin() const noexcept {
+			return const_iterator(bits);
+		}
+
+		constexpr const_iterator end() const noexcept {
+			return const_iterator();
+		}
+
+		constexpr bool operator==(const PropertyIdSet& aOther) const noexcept = default;
+	private:
+		static constexpr uint64_t toBit(int aId) noexcept {
+			return static_cast<uint64_t>(1) << aId;
+		}
+
+		uint64_t bits = 0;
+	};
 
 	// Creates a list of numeric IDs of all properties
 	static inline PropertyIdSet toPropertyIdSet(const PropertyList& aProperties) {
@@ -69,6 +169,15 @@ namespace webserver {
 		return ret;
 	}
 
+	// Creates a list of property names escaped for JsonWriter (indexed by property ID)
+	static inline StringList toEscapedPropertyKeys(const PropertyList& aProperties) {
+		StringList ret;
+		for (const auto& p : aProperties)
+			ret.push_back(JsonWriter::escapeKey(p.name));
+
+		return ret;
+	}
+
 	static inline int findPropertyByName(const string& aPropertyName, const PropertyList& aProperties) {
 		auto p = ranges::find_if(aProperties, [&](const Property& aProperty) { return aProperty.name == aPropertyName; });
 		if (p == aProperties.end()) {
@@ -97,7 +206,10 @@ namespace webserver {
 			properties(aProperties),
 			stringF(aStringF), numberF(aNumberF), 
 			customSorterF(aSorterF), jsonF(aJsonF),
-			customFilterF(aFilterF) { }
+			customFilterF(aFilterF), escapedKeys(toEscapedPropertyKeys(aProperties)), allProperties(toPropertyIdSet(aProperties)) {
+
+			dcassert(aProperties.size() <= PropertyIdSet::MAX_PROPERTIES);
+		}
 
 		// Information about each property
 		const PropertyList& properties;
@@ -116,6 +228,12 @@ namespace webserver {
 
 		// Returns true if the item matches filter
 		const CustomFilterFunction customFilterF;
+
+		// Property names that have been escaped for JsonWriter
+		const StringList escapedKeys;
+
+		// IDs of all properties
+		const PropertyIdSet allProperties;
 	};
 }
 
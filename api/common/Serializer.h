@@ -22,6 +22,7 @@
 #include <api/common/Property.h>
 
 #include <web-server/Access.h>
+#include <web-server/JsonWriter.h>
 
 #include <airdcpp/core/header/typedefs.h>
 #include <airdcpp/core/classes/tribool.h>
@@ -136,21 +137,7 @@ namespace webserver {
 		// Throws for invalid parameters
 		template <class ContainerT, class FuncT>
 		static json serializeFromPosition(int aBeginPos, int aCount, const ContainerT& aList, const FuncT& aF) {
-			auto listSize = static_cast<int>(std::distance(std::begin(aList), std::end(aList)));
-			if (listSize == 0) {
-				return json::array();
-			}
-
-			if (aBeginPos >= listSize || aCount <= 0) {
-				throw std::domain_error("Invalid range");
-			}
-
-			auto beginIter = std::begin(aList);
-			std::advance(beginIter, aBeginPos);
-
-			auto endIter = beginIter;
-			std::advance(endIter, min(listSize - aBeginPos, aCount));
-
+			auto [beginIter, endIter] = getPositionRange(aBeginPos, aCount, aList);
 			return serializeRange(beginIter, endIter, aF);
 		}
 
@@ -174,7 +161,7 @@ namespace webserver {
 		// Serialize item with ID and all properties
 		template <class T>
 		static json serializeItem(const T& aItem, const PropertyItemHandler<T>& aHandler) noexcept {
-			return serializePartialItem(aItem, aHandler, toPropertyIdSet(aHandler.properties));
+			return serializePartialItem(aItem, aHandler, aHandler.allProperties);
 		}
 
 		// Serialize item with ID and specified properties
@@ -214,6 +201,66 @@ namespace webserver {
 			return j;
 		}
 
+		// Write a list of items provided by the handler with a custom range
+		// Throws for invalid range parameters
+		template <class T, class ContainerT>
+		static void writeItemList(int aStart, int aCount, const PropertyItemHandler<T>& aHandler, const ContainerT& aItems, JsonWriter& writer_) {
+			auto [beginIter, endIter] = getPositionRange(aStart, aCount, aItems);
+			writeItemRange(beginIter, endIter, aHandler, writer_);
+		}
+
+		// Write a list of items provided by the handler
+		template <class T, class ContainerT>
+		static void writeItemList(const PropertyItemHandler<T>& aHandler, const ContainerT& aItems, JsonWriter& writer_) {
+			writeItemRange(std::begin(aItems), std::end(aItems), aHandler, writer_);
+		}
+
+		// Serialized versions of the above that can be passed to ApiRequest::setResponseBodyRaw
+		template <class T, class ContainerT>
+		static string writeItemList(int aStart, int aCount, const PropertyItemHandler<T>& aHandler, const ContainerT& aItems) {
+			string ret;
+			JsonWriter writer(ret);
+			writeItemList(aStart, aCount, aHandler, aItems, writer);
+			return ret;
+		}
+
+		template <class T, class ContainerT>
+		static string writeItemList(const PropertyItemHandler<T>& aHandler, const ContainerT& aItems) {
+			string ret;
+			JsonWriter writer(ret);
+			writeItemList(aHandler, aItems, writer);
+			return ret;
+		}
+
+		// Write item with ID and all properties
+		template <class T>
+		static void writeItem(const T& aItem, const PropertyItemHandler<T>& aHandler, JsonWriter& writer_) {
+			writer_.startObject();
+			for (const auto& prop : aHandler.properties) {
+				writeProperty(aItem, aHandler, prop.id, writer_);
+			}
+
+			writer_.field("id", aItem->getToken());
+			writer_.endObject();
+		}
+
+		// Write item with ID and specified properties
+		template <class T>
+		static void writePartialItem(const T& aItem, const PropertyItemHandler<T>& aHandler, const PropertyIdSet& aPropertyIds, JsonWriter& writer_) {
+			writer_.startObject();
+			writeProperties(aItem, aHandler, aPropertyIds, writer_);
+			writer_.field("id", aItem->getToken());
+			writer_.endObject();
+		}
+
+		// Write specified item properties into the current object (without the ID)
+		template <class T>
+		static void writeProperties(const T& aItem, const PropertyItemHandler<T>& aHandler, const PropertyIdSet& aPropertyIds, JsonWriter& writer_) {
+			for (auto id : aPropertyIds) {
+				writeProperty(aItem, aHandler, id, writer_);
+			}
+		}
+
 		static json serializeChangedProperties(const json& aNewProperties, const json& aOldProperties) noexcept;
 
 		template<typename IdT>
@@ -227,6 +274,60 @@ namespace webserver {
 	private:
 		static void appendOnlineUserFlags(const OnlineUserPtr& aUser, StringSet& flags_) noexcept;
 
+		// Throws for invalid parameters
+		template <class ContainerT>
+		static auto getPositionRange(int aBeginPos, int aCount, const ContainerT& aList) {
+			auto listSize = static_cast<int>(std::distance(std::begin(aList), std::end(aList)));
+			if (listSize == 0) {
+				return std::make_pair(std::begin(aList), std::end(aList));
+			}
+
+			if (aBeginPos >= listSize || aCount <= 0) {
+				throw std::domain_error("Invalid range");
+			}
+
+			auto beginIter = std::begin(aList);
+			std::advance(beginIter, aBeginPos);
+
+			auto endIter = beginIter;
+			std::advance(endIter, min(listSize - aBeginPos, aCount));
+
+			return std::make_pair(beginIter, endIter);
+		}
+
+		template <class IterT, class T>
+		static void writeItemRange(const IterT& aBegin, const IterT& aEnd, const PropertyItemHandler<T>& aHandler, JsonWriter& writer_) {
+			writer_.startArray();
+			std::for_each(aBegin, aEnd, [&](const T& aItem) {
+				writeItem(aItem, aHandler, writer_);
+			});
+			writer_.endArray();
+		}
+
+		template <class T>
+		static void writeProperty(const T& aItem, const PropertyItemHandler<T>& aHandler, int aId, JsonWriter& writer_) {
+			writer_.escapedKey(aHandler.escapedKeys[aId]);
+
+			switch (aHandler.properties[aId].serializationMethod) {
+			case SERIALIZE_NUMERIC: {
+				writer_.value(aHandler.numberF(aItem, aId));
+				break;
+			}
+			case SERIALIZE_TEXT: {
+				writer_.value(aHandler.stringF(aItem, aId));
+				break;
+			}
+			case SERIALIZE_BOOL: {
+				writer_.value(aHandler.numberF(aItem, aId) == 0 ? false : true);
+				break;
+			}
+			case SERIALIZE_CUSTOM: {
+				writer_.value(aHandler.jsonF(aItem, aId));
+				break;
+			}
+			}
+		}
+
 		template <class IterT, class FuncT>
 		static json serializeRange(const IterT& aBegin, const IterT& aEnd, const FuncT& aF) noexcept {
 			auto ret = json::array();
@@ -51,7 +51,7 @@ public:
 
 			// Merge
 			if (type == aTask.type) {
-				updatedProperties.insert(aTask.updatedProperties.begin(), aTask.updatedProperties.end());
+				updatedProperties.insert(aTask.updatedProperties);
 				return;
 			}
 
@@ -75,7 +75,7 @@ public:
 
 	void updateItem(const T& aItem, const PropertyIdSet& aUpdatedProperties) {
 		WLock l(cs);
-		updatedProperties.insert(aUpdatedProperties.begin(), aUpdatedProperties.end());
+		updatedProperties.insert(aUpdatedProperties);
 		queueTask(aItem, MergeTask(UPDATE_ITEM, aUpdatedProperties));
 	}
 
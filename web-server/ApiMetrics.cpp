@@ -0,0 +1,275 @@
+/*
+* Copyright (C) 2011-2024 AirDC++ Project
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+*/
+
+#include "stdinc.h"
+
+#include <web-server/ApiMetrics.h>
+#include <web-server/ApiRequest.h>
+
+#include <airdcpp/util/Util.h>
+
+#include <bit>
+#include <sstream>
+
+namespace webserver {
+	size_t LatencyHistogram::getBucketIndex(uint64_t aValue) noexcept {
+		if (aValue < SUB_BUCKET_COUNT) {
+			return static_cast<size_t>(aValue);
+		}
+
+		// Split each power of two into SUB_BUCKET_COUNT linear buckets
+		const auto msb = std::bit_width(aValue) - 1;
+		const auto shift = msb - SUB_BUCKET_BITS;
+		const auto subBucket = (aValue >> shift) & (SUB_BUCKET_COUNT - 1);
+		return static_cast<size_t>((shift + 1) * SUB_BUCKET_COUNT + subBucket);
+	}
+
+	uint64_t LatencyHistogram::getBucketUpperBound(size_t aIndex) noexcept {
+		if (aIndex < SUB_BUCKET_COUNT) {
+			return aIndex;
+		}
+
+		const auto shift = aIndex / SUB_BUCKET_COUNT - 1;
+		const auto subBucket = aIndex % SUB_BUCKET_COUNT;
+		return ((SUB_BUCKET_COUNT + subBucket + 1) << shift) - 1;
+	}
+
+	void LatencyHistogram::record(uint64_t aMicros) noexcept {
+		const auto value = std::min(aMicros, MAX_VALUE);
+
+		buckets[getBucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+		count.fetch_add(1, std::memory_order_relaxed);
+		sum.fetch_add(value, std::memory_order_relaxed);
+
+		auto currentMax = max.load(std::memory_order_relaxed);
+		while (value > currentMax && !max.compare_exchange_weak(currentMax, value, std::memory_order_relaxed)) {
+			// Retry
+		}
+	}
+
+	uint64_t LatencyHistogram::getPercentile(double aPercentile) const noexcept {
+		const auto total = getCount();
+		if (total == 0) {
+			return 0;
+		}
+
+		const auto target = std::max<uint64_t>(static_cast<uint64_t>(static_cast<double>(total) * aPercentile / 100.0), 1);
+
+		uint64_t cumulative = 0;
+		for (size_t i = 0; i < BUCKET_COUNT; i++) {
+			cumulative += buckets[i].load(std::memory_order_relaxed);
+			if (cumulative >= target) {
+				return std::min(getBucketUpperBound(i), getMax());
+			}
+		}
+
+		return getMax();
+	}
+
+	uint64_t LatencyHistogram::getCountBelow(uint64_t aMicros) const noexcept {
+		uint64_t ret = 0;
+		for (size_t i = 0; i < BUCKET_COUNT && getBucketUpperBound(i) <= aMicros; i++) {
+			ret += buckets[i].load(std::memory_order_relaxed);
+		}
+
+		return ret;
+	}
+
+	ApiMetrics::RouteMetrics& ApiMetrics::getRouteMetrics(const string& aApiModule, const string& aMethod, const string& aPath) noexcept {
+		const auto key = aApiModule + " " + aMethod + " " + aPath;
+
+		Lock l(cs);
+		auto& metrics = routes[key];
+		if (!metrics) {
+			metrics = make_unique<RouteMetrics>(aApiModule, aMethod, aPath);
+		}
+
+		return *metrics;
+	}
+
+	void ApiMetrics::onApiResponse(http::status aStatus) noexcept {
+		if (aStatus == CODE_DEFERRED) {
+			deferredResponses.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+
+		const auto code = static_cast<size_t>(aStatus);
+		if (code < STATUS_CODE_COUNT) {
+			statusCodes[code].fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+
+	void ApiMetrics::onData(TransportType aType, Direction aDirection, size_t aBytes) noexcept {
+		transferredBytes[static_cast<size_t>(aType) * DIRECTION_COUNT + static_cast<size_t>(aDirection)].fetch_add(aBytes, std::memory_order_relaxed);
+	}
+
+	const string& ApiMetrics::transportToString(size_t aTransport) noexcept {
+		static const string transports[TRANSPORT_COUNT] = { "socket", "http_api", "http_file" };
+		return transports[aTransport];
+	}
+
+	const string& ApiMetrics::directionToString(size_t aDirection) noexcept {
+		static const string directions[DIRECTION_COUNT] = { "in", "out" };
+		return directions[aDirection];
+	}
+
+	json ApiMetrics::toJson(const WsSendQueueStats& aQueueStats) const {
+		auto routesJson = json::array();
+
+		{
+			Lock l(cs);
+			for (const auto& metrics: routes | views::values) {
+				const auto& latency = metrics->latency;
+				const auto requestCount = latency.getCount();
+				routesJson.push_back({
+					{ "module", metrics->apiModule },
+					{ "method", metrics->method },
+					{ "path", metrics->path },
+					{ "count", requestCount },
+					{ "mean_us", requestCount > 0 ? latency.getSum() / requestCount : 0 },
+					{ "p50_us", latency.getPercentile(50) },
+					{ "p90_us", latency.getPercentile(90) },
+					{ "p99_us", latency.getPercentile(99) },
+					{ "max_us", latency.getMax() },
+				});
+			}
+		}
+
+		auto statusCodesJson = json::object();
+		for (size_t i = 0; i < STATUS_CODE_COUNT; i++) {
+			const auto codeCount = statusCodes[i].load(std::memory_order_relaxed);
+			if (codeCount > 0) {
+				statusCodesJson[Util::toString(i)] = codeCount;
+			}
+		}
+
+		auto bytesJson = json::object();
+		for (size_t t = 0; t < TRANSPORT_COUNT; t++) {
+			for (size_t d = 0; d < DIRECTION_COUNT; d++) {
+				bytesJson[transportToString(t)][directionToString(d)] = transferredBytes[t * DIRECTION_COUNT + d].load(std::memory_order_relaxed);
+			}
+		}
+
+		return {
+			{ "routes", routesJson },
+			{ "status_codes", statusCodesJson },
+			{ "deferred_responses", deferredResponses.load(std::memory_order_relaxed) },
+			{ "transferred_bytes", bytesJson },
+			{ "socket_send_queue", {
+				{ "messages", aQueueStats.queuedMessages },
+				{ "bytes", aQueueStats.queuedBytes },
+				{ "coalesced_messages", aQueueStats.coalescedMessages },
+				{ "dropped_messages", aQueueStats.droppedMessages },
+				{ "disconnected_clients", aQueueStats.disconnectedClients },
+			} },
+		};
+	}
+
+	static string escapeLabel(const string& aValue) noexcept {
+		string ret;
+		ret.reserve(aValue.size());
+		for (auto c: aValue) {
+			if (c == '\\' || c == '"') {
+				ret += '\\';
+			} else if (c == '\n') {
+				ret += "\\n";
+				continue;
+			}
+
+			ret += c;
+		}
+
+		return ret;
+	}
+
+	// Exact decimal seconds without the rounding of the default stream precision (e.g. 2500 -> "0.0025")
+	static string formatMicrosAsSeconds(uint64_t aMicros) noexcept {
+		auto ret = std::to_string(aMicros / 1000000);
+
+		auto fraction = std::to_string(aMicros % 1000000);
+		fraction.insert(0, 6 - fraction.size(), '0');
+		while (!fraction.empty() && fraction.back() == '0') {
+			fraction.pop_back();
+		}
+
+		if (!fraction.empty()) {
+			ret += '.' + fraction;
+		}
+
+		return ret;
+	}
+
+	string ApiMetrics::toPrometheus(const WsSendQueueStats& aQueueStats) const {
+		// Histogram bucket bounds in microseconds (reported in seconds)
+		static const std::array<uint64_t, 14> bucketBounds = { 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000, 250000, 500000, 1000000, 2500000, 5000000, 10000000 };
+
+		std::ostringstream os;
+		os << "# HELP airdcpp_api_request_duration_seconds Time spent in API request handlers\n";
+		os << "# TYPE airdcpp_api_request_duration_seconds histogram\n";
+
+		{
+			Lock l(cs);
+			for (const auto& metrics: routes | views::values) {
+				const auto labels = "module=\"" + escapeLabel(metrics->apiModule) + "\",method=\"" + escapeLabel(metrics->method) + "\",path=\"" + escapeLabel(metrics->path) + "\"";
+				const auto& latency = metrics->latency;
+				for (auto bound: bucketBounds) {
+					os << "airdcpp_api_request_duration_seconds_bucket{" << labels << ",le=\"" << formatMicrosAsSeconds(bound) << "\"} " << latency.getCountBelow(bound) << "\n";
+				}
+
+				os << "airdcpp_api_request_duration_seconds_bucket{" << labels << ",le=\"+Inf\"} " << latency.getCount() << "\n";
+				os << "airdcpp_api_request_duration_seconds_sum{" << labels << "} " << formatMicrosAsSeconds(latency.getSum()) << "\n";
+				os << "airdcpp_api_request_duration_seconds_count{" << labels << "} " << latency.getCount() << "\n";
+			}
+		}
+
+		os << "# HELP airdcpp_api_responses_total API responses by status code\n";
+		os << "# TYPE airdcpp_api_responses_total counter\n";
+		for (size_t i = 0; i < STATUS_CODE_COUNT; i++) {
+			const auto codeCount = statusCodes[i].load(std::memory_order_relaxed);
+			if (codeCount > 0) {
+				os << "airdcpp_api_responses_total{code=\"" << i << "\"} " << codeCount << "\n";
+			}
+		}
+
+		os << "# HELP airdcpp_api_deferred_responses_total API requests that were completed asynchronously\n";
+		os << "# TYPE airdcpp_api_deferred_responses_total counter\n";
+		os << "airdcpp_api_deferred_responses_total " << deferredResponses.load(std::memory_order_relaxed) << "\n";
+
+		os << "# HELP airdcpp_transferred_bytes_total Bytes transferred by the web server\n";
+		os << "# TYPE airdcpp_transferred_bytes_total counter\n";
+		for (size_t t = 0; t < TRANSPORT_COUNT; t++) {
+			for (size_t d = 0; d < DIRECTION_COUNT; d++) {
+				os << "airdcpp_transferred_bytes_total{transport=\"" << transportToString(t) << "\",direction=\"" << directionToString(d) << "\"} " 
+					<< transferredBytes[t * DIRECTION_COUNT + d].load(std::memory_order_relaxed) << "\n";
+			}
+		}
+
+		os << "# HELP airdcpp_websocket_send_queue_messages Queued outgoing WebSocket messages\n";
+		os << "# TYPE airdcpp_websocket_send_queue_messages gauge\n";
+		os << "airdcpp_websocket_send_queue_messages " << aQueueStats.queuedMessages << "\n";
+		os << "# HELP airdcpp_websocket_send_queue_bytes Queued outgoing WebSocket bytes\n";
+		os << "# TYPE airdcpp_websocket_send_queue_bytes gauge\n";
+		os << "airdcpp_websocket_send_queue_bytes " << aQueueStats.queuedBytes << "\n";
+		os << "# HELP airdcpp_websocket_send_queue_dropped_total Outgoing WebSocket messages that were dropped or coalesced\n";
+		os << "# TYPE airdcpp_websocket_send_queue_dropped_total counter\n";
+		os << "airdcpp_websocket_send_queue_dropped_total{reason=\"dropped\"} " << aQueueStats.droppedMessages << "\n";
+		os << "airdcpp_websocket_send_queue_dropped_total{reason=\"coalesced\"} " << aQueueStats.coalescedMessages << "\n";
+
+		return os.str();
+	}
+}
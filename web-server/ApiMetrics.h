@@ -0,0 +1,112 @@
+/*
+* Copyright (C) 2011-2024 AirDC++ Project
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+*/
+
+#ifndef DCPLUSPLUS_WEBSERVER_APIMETRICS_H
+#define DCPLUSPLUS_WEBSERVER_APIMETRICS_H
+
+#include "forward.h"
+
+#include <web-server/IServerEndpoint.h>
+#include <web-server/WebServerManagerListener.h>
+
+#include <airdcpp/core/thread/CriticalSection.h>
+
+#include <array>
+#include <atomic>
+
+namespace webserver {
+	// Lock-free latency histogram with log-linear buckets (HDR-style, max relative error of 12.5%)
+	class LatencyHistogram {
+	public:
+		// Values are recorded in microseconds, larger values are clamped
+		static constexpr int SUB_BUCKET_BITS = 3;
+		static constexpr uint64_t SUB_BUCKET_COUNT = 1 << SUB_BUCKET_BITS;
+		static constexpr int MAX_VALUE_BITS = 36;
+		static constexpr uint64_t MAX_VALUE = (1ULL << MAX_VALUE_BITS) - 1;
+		static constexpr size_t BUCKET_COUNT = (MAX_VALUE_BITS - SUB_BUCKET_BITS + 1) * SUB_BUCKET_COUNT;
+
+		void record(uint64_t aMicros) noexcept;
+
+		uint64_t getCount() const noexcept {
+			return count.load(std::memory_order_relaxed);
+		}
+
+		uint64_t getSum() const noexcept {
+			return sum.load(std::memory_order_relaxed);
+		}
+
+		uint64_t getMax() const noexcept {
+			return max.load(std::memory_order_relaxed);
+		}
+
+		// Returns the upper bound of the bucket containing the percentile (0-100)
+		uint64_t getPercentile(double aPercentile) const noexcept;
+
+		// Number of recorded values that are (approximately) less or equal to aMicros
+		uint64_t getCountBelow(uint64_t aMicros) const noexcept;
+	private:
+		static size_t getBucketIndex(uint64_t aValue) noexcept;
+		static uint64_t getBucketUpperBound(size_t aIndex) noexcept;
+
+		std::array<std::atomic<uint64_t>, BUCKET_COUNT> buckets {};
+		std::atomic<uint64_t> count { 0 };
+		std::atomic<uint64_t> sum { 0 };
+		std::atomic<uint64_t> max { 0 };
+	};
+
+	// Request latencies, status codes and transferred bytes of the API
+	class ApiMetrics {
+	public:
+		struct RouteMetrics {
+			RouteMetrics(const string& aApiModule, const string& aMethod, const string& aPath) : apiModule(aApiModule), method(aMethod), path(aPath) {}
+
+			const string apiModule;
+			const string method;
+			const string path;
+
+			LatencyHistogram latency;
+		};
+
+		// Returns metrics for the handler (the returned reference stays valid for the lifetime of this object)
+		RouteMetrics& getRouteMetrics(const string& aApiModule, const string& aMethod, const string& aPath) noexcept;
+
+		void onApiResponse(http::status aStatus) noexcept;
+		void onData(TransportType aType, Direction aDirection, size_t aBytes) noexcept;
+
+		json toJson(const WsSendQueueStats& aQueueStats) const;
+
+		// Prometheus text exposition format
+		string toPrometheus(const WsSendQueueStats& aQueueStats) const;
+	private:
+		static constexpr size_t STATUS_CODE_COUNT = 600;
+		static constexpr size_t TRANSPORT_COUNT = 3;
+		static constexpr size_t DIRECTION_COUNT = 2;
+
+		static const string& transportToString(size_t aTransport) noexcept;
+		static const string& directionToString(size_t aDirection) noexcept;
+
+		mutable CriticalSection cs;
+		std::map<string, unique_ptr<RouteMetrics>> routes;
+
+		std::array<std::atomic<uint64_t>, STATUS_CODE_COUNT> statusCodes {};
+		std::atomic<uint64_t> deferredResponses { 0 };
+		std::array<std::atomic<uint64_t>, TRANSPORT_COUNT * DIRECTION_COUNT> transferredBytes {};
+	};
+}
+
+#endif
@@ -23,9 +23,10 @@
 #include <airdcpp/user/CID.h>
 #include <airdcpp/hash/value/MerkleTree.h>
 
-#include <airdcpp/util/text/StringTokenizer.h>
 #include <airdcpp/util/Util.h>
 
+#include <charconv>
+
 namespace webserver {
 	ApiRequest::ApiRequest(const string& aUrl, const string& aMethod, json&& aBody, const SessionPtr& aSession, const ApiDeferredHandler& aDeferredHandler, json& output_, json& error_) :
 		session(aSession), path(aUrl), methodStr(aMethod), requestJson(std::move(aBody)), responseJsonData(output_), responseJsonError(error_), deferredHandler(aDeferredHandler)
@@ -35,7 +36,16 @@ namespace webserver {
 			throw std::invalid_argument("Invalid URL path (the path should start with /api/v" + Util::toString(API_VERSION) + "/)");
 		}
 
-		pathTokens = StringTokenizer<std::string, deque>(aUrl.substr(4), '/').getTokens();
+		// Split the path (empty tokens are skipped)
+		auto tokenStr = std::string_view(path).substr(4);
+		while (!tokenStr.empty()) {
+			auto len = std::min(tokenStr.find('/'), tokenStr.size());
+			if (len > 0 && !pathTokens.push_back(tokenStr.substr(0, len))) {
+				throw std::invalid_argument("Too many URL parameters");
+			}
+
+			tokenStr.remove_prefix(std::min(len + 1, tokenStr.size()));
+		}
 
 		if (aMethod == "GET") {
 			method = METHOD_GET;
@@ -64,68 +74,147 @@ namespace webserver {
 		}
 
 		// Version
-		const auto version = pathTokens.front();
-		pathTokens.pop_front();
+		const auto version = pathTokens[0];
 
 		// API Module
-		apiModule = pathTokens.front();
-		pathTokens.pop_front();
+		apiModule = pathTokens[1];
+		pathTokens.pop_front(2);
 
 		if (version.size() < 2) {
 			throw std::invalid_argument("Invalid API version format");
 		}
 
-		apiVersion = Util::toInt(version.substr(1));
+		apiVersion = 0;
+		std::from_chars(version.data() + 1, version.data() + version.size(), apiVersion);
+	}
+
+	bool ApiRequest::PathTokenList::push_back(std::string_view aToken) noexcept {
+		if (count == MAX_TOKENS) {
+			return false;
+		}
+
+		tokens[count++] = aToken;
+		return true;
+	}
+
+	void ApiRequest::PathTokenList::pop_front(size_t aCount) noexcept {
+		first = std::min(first + aCount, count);
 	}
 
-	void ApiRequest::setNamedParams(const NamedParamMap& aParams) noexcept {
+	bool ApiRequest::NamedParamList::add(std::string_view aName, std::string_view aValue, bool aIsNumber) noexcept {
+		if (count == MAX_PARAMS) {
+			return false;
+		}
+
+		auto& param = params[count++];
+		param.name = aName;
+		param.value = aValue;
+		param.number = 0;
+		if (aIsNumber) {
+			std::from_chars(aValue.data(), aValue.data() + aValue.size(), param.number);
+		}
+
+		return true;
+	}
+
+	const ApiRequest::NamedParam* ApiRequest::NamedParamList::find(std::string_view aName) const noexcept {
+		for (size_t i = 0; i < count; i++) {
+			if (params[i].name == aName) {
+				return &params[i];
+			}
+		}
+
+		return nullptr;
+	}
+
+	void ApiRequest::setNamedParams(const NamedParamList& aParams) noexcept {
 		namedParameters = aParams;
 	}
 
 	void ApiRequest::popParam(size_t aCount) noexcept {
-		pathTokens.erase(pathTokens.begin(), pathTokens.begin() + aCount);
+		pathTokens.pop_front(aCount);
+	}
+
+	const ApiRequest::NamedParam& ApiRequest::getNamedParam(std::string_view aName) const noexcept {
+		static const NamedParam emptyParam;
+
+		auto param = namedParameters.find(aName);
+		dcassert(param);
+		return param ? *param : emptyParam;
 	}
 
-	size_t ApiRequest::getTokenParam(const string& aName) const noexcept {
-		return Util::toSizeT(namedParameters.at(aName));
+	size_t ApiRequest::getTokenParam(std::string_view aName) const noexcept {
+		return static_cast<size_t>(getNamedParam(aName).number);
 	}
 
-	const string& ApiRequest::getStringParam(const string& aName) const noexcept {
-		return namedParameters.at(aName);
+	std::string_view ApiRequest::getStringParam(std::string_view aName) const noexcept {
+		return getNamedParam(aName).value;
 	}
 
-	int ApiRequest::getRangeParam(const string& aName) const noexcept {
-		return Util::toInt(namedParameters.at(aName));
+	int ApiRequest::getRangeParam(std::string_view aName) const noexcept {
+		return static_cast<int>(getNamedParam(aName).number);
 	}
 
-	int64_t ApiRequest::getSizeParam(const string& aName) const noexcept {
-		return Util::toInt64(namedParameters.at(aName));
+	int64_t ApiRequest::getSizeParam(std::string_view aName) const noexcept {
+		return static_cast<int64_t>(getNamedParam(aName).number);
 	}
 
-	const std::string& ApiRequest::getPathTokenAt(int aIndex) const noexcept {
+	std::string_view ApiRequest::getPathTokenAt(int aIndex) const noexcept {
 		return pathTokens[aIndex];
 	}
 
-	TTHValue ApiRequest::getTTHParam(const string& aName) const {
-		const auto& param = getStringParam(aName);
-		if (!Encoder::isBase32(param.c_str())) {
+	// Decodes a base32 param without allocating
+	static bool decodeBase32Param(std::string_view aParam, uint8_t* dst_, size_t aLen) noexcept {
+		// Encoder expects a null-terminated string
+		char buf[64];
+		if (aParam.size() >= sizeof(buf)) {
+			return false;
+		}
+
+		memcpy(buf, aParam.data(), aParam.size());
+		buf[aParam.size()] = '\0';
+		if (!Encoder::isBase32(buf)) {
+			return false;
+		}
+
+		Encoder::fromBase32(buf, dst_, aLen);
+		return true;
+	}
+
+	TTHValue ApiRequest::getTTHParam(std::string_view aName) const {
+		uint8_t tth[TTHValue::BYTES];
+		if (!decodeBase32Param(getNamedParam(aName).value, tth, sizeof(tth))) {
 			throw std::invalid_argument("Invalid TTH URL parameter");
 		}
 
-		return TTHValue(param);
+		return TTHValue(tth);
 	}
 
-	CID ApiRequest::getCIDParam(const string& aName) const {
-		const auto& param = getStringParam(aName);
-		if (!Encoder::isBase32(param.c_str())) {
+	CID ApiRequest::getCIDParam(std::string_view aName) const {
+		uint8_t cid[CID::SIZE];
+		if (!decodeBase32Param(getNamedParam(aName).value, cid, sizeof(cid))) {
 			throw std::invalid_argument("Invalid CID URL parameter");
 		}
 
-		return CID(param);
+		return CID(cid);
 	}
 
 
+	void ApiRequest::setResponseBodyRaw(string&& aResponse) {
+		if (responseRawData) {
+			*responseRawData = std::move(aResponse);
+		} else {
+			responseJsonData = json::parse(aResponse);
+		}
+	}
+
 	ApiCompletionF ApiRequest::defer() const noexcept {
 		return deferredHandler();
 	}
+
+	void ApiRequest::wrapDeferredHandler(CompletionWrapperF&& aWrapper) noexcept {
+		deferredHandler = [handler = std::move(deferredHandler), wrapper = std::move(aWrapper)]() {
+			return wrapper(handler());
+		};
+	}
 }
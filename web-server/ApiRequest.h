@@ -25,6 +25,9 @@
 #include <airdcpp/core/header/typedefs.h>
 #include <airdcpp/core/types/GetSet.h>
 
+#include <array>
+#include <string_view>
+
 #define TOKEN_PARAM_ID "id_param"
 #define TTH_PARAM_ID "tth_param"
 #define CID_PARAM_ID "cid_param"
@@ -44,17 +47,74 @@ namespace webserver {
 
 	class ApiRequest {
 	public:
-		using PathTokenList = std::deque<std::string>;
-		using NamedParamMap = std::map<std::string, std::string>;
-
-		// Throws std::invalid_argument on validation errors
+		// Path tokens are views to the request path (no allocations are needed for routing)
+		class PathTokenList {
+		public:
+			// Maximum number of non-empty path segments after /api (requests with more segments are rejected with "Too many URL parameters")
+			static constexpr size_t MAX_TOKENS = 32;
+
+			size_t size() const noexcept {
+				return count - first;
+			}
+
+			bool empty() const noexcept {
+				return size() == 0;
+			}
+
+			std::string_view operator[](size_t aIndex) const noexcept {
+				return tokens[first + aIndex];
+			}
+
+			const std::string_view* begin() const noexcept {
+				return tokens.data() + first;
+			}
+
+			const std::string_view* end() const noexcept {
+				return tokens.data() + count;
+			}
+
+			// Returns false if the maximum token count has been reached
+			bool push_back(std::string_view aToken) noexcept;
+			void pop_front(size_t aCount = 1) noexcept;
+		private:
+			std::array<std::string_view, MAX_TOKENS> tokens;
+			size_t first = 0;
+			size_t count = 0;
+		};
+
+		struct NamedParam {
+			std::string_view name;
+			std::string_view value;
+
+			// Parsed when the handler is matched (numeric params only)
+			uint64_t number = 0;
+		};
+
+		// Named params of the matched request handler
+		class NamedParamList {
+		public:
+			static constexpr size_t MAX_PARAMS = 8;
+
+			// Returns false if the maximum param count has been reached
+			bool add(std::string_view aName, std::string_view aValue, bool aIsNumber) noexcept;
+			const NamedParam* find(std::string_view aName) const noexcept;
+		private:
+			std::array<NamedParam, MAX_PARAMS> params;
+			size_t count = 0;
+		};
+
+		// Throws std::invalid_argument on validation errors (including paths with more than PathTokenList::MAX_TOKENS segments)
 		ApiRequest(const std::string& aUrl, const std::string& aMethod, json&& aBody, const SessionPtr& aSession, const ApiDeferredHandler& aDeferredHandler, json& output_, json& error_);
 
+		// Path tokens and params point to the path owned by this request
+		ApiRequest(ApiRequest&) = delete;
+		ApiRequest& operator=(ApiRequest&) = delete;
+
 		int getApiVersion() const noexcept {
 			return apiVersion;
 		}
 
-		const std::string& getApiModule() const noexcept {
+		std::string_view getApiModule() const noexcept {
 			return apiModule;
 		}
 
@@ -72,19 +132,20 @@ namespace webserver {
 
 		void popParam(size_t aCount = 1) noexcept;
 
-		const std::string& getStringParam(const string& aName) const noexcept;
-		const std::string& getPathTokenAt(int aIndex) const noexcept;
+		// The view is valid for the lifetime of the request
+		std::string_view getStringParam(std::string_view aName) const noexcept;
+		std::string_view getPathTokenAt(int aIndex) const noexcept;
 
 		// Throws in case of errors
-		TTHValue getTTHParam(const string& aName = TTH_PARAM_ID) const;
+		TTHValue getTTHParam(std::string_view aName = TTH_PARAM_ID) const;
 
 		// Throws in case of errors
-		CID getCIDParam(const string& aName = CID_PARAM_ID) const;
+		CID getCIDParam(std::string_view aName = CID_PARAM_ID) const;
 
 		// Use different naming to avoid accidentally using wrong conversion...
-		size_t getTokenParam(const string& aName = TOKEN_PARAM_ID) const noexcept;
-		int getRangeParam(const string& aName) const noexcept;
-		int64_t getSizeParam(const string& aName) const noexcept;
+		size_t getTokenParam(std::string_view aName = TOKEN_PARAM_ID) const noexcept;
+		int getRangeParam(std::string_view aName) const noexcept;
+		int64_t getSizeParam(std::string_view aName) const noexcept;
 
 		bool hasRequestBody() const noexcept {
 			return !requestJson.is_null();
@@ -102,6 +163,15 @@ namespace webserver {
 			responseJsonData = aResponse;
 		}
 
+		// Set a response that has been serialized already (e.g. with JsonWriter)
+		// The data is parsed if the transport didn't provide a raw output (throws json::exception for invalid JSON)
+		void setResponseBodyRaw(std::string&& aResponse);
+
+		// Transports may use the raw response directly instead of serializing the JSON output
+		void setRawResponseOutput(std::string* output_) noexcept {
+			responseRawData = output_;
+		}
+
 		void setResponseErrorStr(const std::string& aError) {
 			responseJsonError = toResponseErrorStr(aError);
 		}
@@ -128,19 +198,40 @@ namespace webserver {
 			return path;
 		}
 
-		void setNamedParams(const NamedParamMap& aParams) noexcept;
+		void setNamedParams(const NamedParamList& aParams) noexcept;
 
 		ApiCompletionF defer() const noexcept;
+
+		// Wrap the completion function that is returned for deferred requests (e.g. for recording metrics)
+		using CompletionWrapperF = std::function<ApiCompletionF (ApiCompletionF&& aCompletionF)>;
+		void wrapDeferredHandler(CompletionWrapperF&& aWrapper) noexcept;
+
+		// Set for requests that were queued by the rate limiter (the tokens have been reserved already)
+		IGETSET(bool, admitted, Admitted, false);
+
+		// Runs a task for the request in the request thread pool after the delay
+		// Transports may set a custom handler so that the task is run in order with their other requests (e.g. API module strands of sockets)
+		using DelayedTaskF = std::function<void (Callback&& aTask, time_t aDelayMillis)>;
+		void setDelayedTaskHandler(DelayedTaskF&& aHandler) noexcept {
+			delayedTaskHandler = std::move(aHandler);
+		}
+
+		const DelayedTaskF& getDelayedTaskHandler() const noexcept {
+			return delayedTaskHandler;
+		}
 	private:
+		DelayedTaskF delayedTaskHandler;
 		SessionPtr session;
 		void validate();
 
+		const NamedParam& getNamedParam(std::string_view aName) const noexcept;
+
 		const string path;
 		const string methodStr;
 		PathTokenList pathTokens;
-		NamedParamMap namedParameters;
+		NamedParamList namedParameters;
 		int apiVersion = -1;
-		std::string apiModule;
+		std::string_view apiModule;
 
 		RequestMethod method = METHOD_LAST;
 
@@ -148,6 +239,7 @@ namespace webserver {
 
 		json& responseJsonData;
 		json& responseJsonError;
+		std::string* responseRawData = nullptr;
 		ApiDeferredHandler deferredHandler;
 	};
 
@@ -22,8 +22,10 @@
 #include <web-server/ApiRouter.h>
 #include <web-server/HttpUtil.h>
 
+#include <web-server/ApiMetrics.h>
 #include <web-server/ApiRequest.h>
 #include <web-server/Session.h>
+#include <web-server/WebServerManager.h>
 
 #include <api/SessionApi.h>
 
@@ -31,6 +33,28 @@
 
 namespace webserver {
 	api_return ApiRouter::handleRequest(RouterRequest& aRequest) noexcept {
+		auto& apiRequest = aRequest.apiRequest;
+		if (apiRequest.getAdmitted()) {
+			// Request queued by the rate limiter, the response is recorded by the completion function of the original request
+			return routeRequest(aRequest);
+		}
+
+		auto& metrics = WebServerManager::getInstance()->getMetrics();
+
+		// Record the final status of deferred requests
+		apiRequest.wrapDeferredHandler([&metrics](ApiCompletionF&& aCompletionF) -> ApiCompletionF {
+			return [&metrics, completionF = std::move(aCompletionF)](api_return aStatus, const json& aResponseJsonData, const json& aResponseErrorJson) {
+				metrics.onApiResponse(aStatus);
+				completionF(aStatus, aResponseJsonData, aResponseErrorJson);
+			};
+		});
+
+		const auto code = routeRequest(aRequest);
+		metrics.onApiResponse(code);
+		return code;
+	}
+
+	api_return ApiRouter::routeRequest(RouterRequest& aRequest) noexcept {
 		auto& apiRequest = aRequest.apiRequest;
 		if (apiRequest.getApiVersion() != API_VERSION) {
 			apiRequest.setResponseErrorStr("Unsupported API version");
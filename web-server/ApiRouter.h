@@ -28,8 +28,10 @@ namespace webserver {
 
 	class ApiRouter {
 	public:
+		// Records the response status in API metrics (the final status of deferred requests is recorded when they are completed)
 		static api_return handleRequest(RouterRequest& aRequest) noexcept;
 	private:
+		static api_return routeRequest(RouterRequest& aRequest) noexcept;
 		static api_return routeAuthRequest(RouterRequest& aRequest);
 	};
 }
@@ -92,17 +92,24 @@ namespace webserver {
 
 	}
 
+	ServerSettingItem::ServerSettingItem(const string& aKey, const string& aTitle, const json& aDefaultValue, Type aType, bool aOptional,
+		const NumberInfo& aNumInfo, const string& aHelp, Type aListItemType, const List& aListObjectFields) :
+		JsonSettingItem(aKey, aDefaultValue, aType, aOptional, aNumInfo, aListItemType),
+		titleKey(ResourceManager::LAST), unitKey(aNumInfo.unitKey), helpKey(ResourceManager::LAST), title(aTitle), help(aHelp), listObjectFields(aListObjectFields) {
+
+	}
+
 	ApiSettingItem::PtrList ServerSettingItem::getListObjectFields() const noexcept {
 		return valueTypesToPtrList(listObjectFields);
 	}
 
 	string ServerSettingItem::getTitle() const noexcept {
-		return ApiSettingItem::formatTitle(STRING_I(titleKey), unitKey);
+		return ApiSettingItem::formatTitle(titleKey == ResourceManager::LAST ? title : STRING_I(titleKey), unitKey);
 	}
 
 	const string& ServerSettingItem::getHelpStr() const noexcept {
 		if (helpKey == ResourceManager::LAST) {
-			return Util::emptyString;
+			return help;
 		}
 
 		return STRING_I(helpKey);
@@ -233,6 +233,10 @@ using SettingReferenceList = std::vector<SettingReference>;
 		ServerSettingItem(const string& aKey, const ResourceManager::Strings aTitleKey, const json& aDefaultValue, Type aType, bool aOptional,
 			const NumberInfo& aNumInfo = NumberInfo(), const ResourceManager::Strings aHelpKey = ResourceManager::LAST, Type aListItemType = TYPE_LAST, const List& aListObjectFields = emptyDefinitionList);
 
+		// Setting without localized strings in the core (the title and help texts are used as such)
+		ServerSettingItem(const string& aKey, const string& aTitle, const json& aDefaultValue, Type aType, bool aOptional,
+			const NumberInfo& aNumInfo = NumberInfo(), const string& aHelp = "", Type aListItemType = TYPE_LAST, const List& aListObjectFields = emptyDefinitionList);
+
 		string getTitle() const noexcept override;
 		ApiSettingItem::PtrList getListObjectFields() const noexcept override;
 		const string& getHelpStr() const noexcept override;
@@ -243,6 +247,10 @@ using SettingReferenceList = std::vector<SettingReference>;
 		const ResourceManager::Strings unitKey;
 		const ResourceManager::Strings helpKey;
 
+		// Used when there are no localized strings
+		const string title;
+		const string help;
+
 		const List& listObjectFields;
 	};
 
@@ -0,0 +1,346 @@
+/*
+* Copyright (C) 2011-2024 AirDC++ Project
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+*/
+
+#include "stdinc.h"
+
+#include <web-server/AssetCache.h>
+#include <web-server/FileServer.h>
+#include <web-server/HttpUtil.h>
+#include <web-server/WebServerManager.h>
+
+#include <airdcpp/core/classes/Exception.h>
+#include <airdcpp/core/classes/ScopedFunctor.h>
+#include <airdcpp/core/io/File.h>
+#include <airdcpp/util/Util.h>
+
+#include <zlib.h>
+
+// Total size of the cached content (all variants)
+#define MAX_CACHE_SIZE 64*1024*1024
+
+// Larger files are streamed from disk
+#define MAX_ASSET_SIZE 8*1024*1024
+
+// How often the file metadata is checked for modifications (milliseconds)
+#define CHECK_INTERVAL 1000
+
+namespace webserver {
+	using namespace dcpp;
+
+	size_t AssetCache::Asset::getMemoryUsage() const noexcept {
+		size_t ret = 0;
+		for (const auto& variant: content) {
+			if (variant) {
+				ret += variant->size();
+			}
+		}
+
+		return ret;
+	}
+
+	AssetCache::AssetPtr AssetCache::getAsset(const string& aPath) noexcept {
+		AssetPtr asset;
+
+		{
+			RLock l(cs);
+			auto i = assets.find(aPath);
+			if (i != assets.end()) {
+				asset = i->second;
+			}
+		}
+
+		const auto tick = GET_TICK();
+		if (asset && asset->lastChecked + CHECK_INTERVAL > tick) {
+			hits++;
+			asset->lastAccess = tick;
+			return asset;
+		}
+
+		int64_t size = -1;
+		time_t modified = 0;
+		uint64_t fileId = 0;
+		if (!FileServer::getFileInfo(aPath, size, modified, fileId) || size > MAX_ASSET_SIZE) {
+			if (asset) {
+				removeAsset(aPath);
+			}
+
+			return nullptr;
+		}
+
+		if (asset && asset->size == size && asset->modified == modified && asset->fileId == fileId) {
+			hits++;
+			asset->lastChecked = tick;
+			asset->lastAccess = tick;
+			return asset;
+		}
+
+		// New or modified file
+		misses++;
+
+		{
+			WLock l(cs);
+			if (!loadingPaths.insert(aPath).second) {
+				// Another request is loading the same file, this one will be served from disk
+				return nullptr;
+			}
+		}
+
+		ScopedFunctor([&]() {
+			WLock l(cs);
+			loadingPaths.erase(aPath);
+		});
+
+		bool compress = false;
+		try {
+			asset = loadAsset(aPath, size, modified, fileId, compress);
+		} catch (const FileException& e) {
+			dcdebug("AssetCache: failed to load %s (%s)\n", aPath.c_str(), e.getError().c_str());
+			removeAsset(aPath);
+			return nullptr;
+		}
+
+		addAsset(asset);
+		if (compress) {
+			compressGzipAsync(asset);
+		}
+
+		return asset;
+	}
+
+	AssetCache::AssetPtr AssetCache::loadAsset(const string& aPath, int64_t aSize, time_t aModified, uint64_t aFileId, bool& compressGzip_) {
+		auto asset = std::make_shared<Asset>();
+		asset->path = aPath;
+		asset->mimeType = HttpUtil::getMimeType(aPath);
+		asset->lastModified = HttpUtil::formatHttpDate(aModified);
+		asset->size = aSize;
+		asset->modified = aModified;
+		asset->fileId = aFileId;
+
+		{
+			File f(aPath, File::READ, File::OPEN);
+			asset->content[ENCODING_IDENTITY] = std::make_shared<const string>(f.read());
+		}
+
+		const auto& identity = *asset->content[ENCODING_IDENTITY];
+		if (isCompressible(aPath)) {
+			// Variants generated by the UI build are preferred (brotli variants are available only from there)
+			asset->content[ENCODING_BROTLI] = loadPrecompressed(aPath + ".br", aModified);
+			asset->content[ENCODING_GZIP] = loadPrecompressed(aPath + ".gz", aModified);
+			compressGzip_ = !asset->content[ENCODING_GZIP];
+
+			// Compression isn't worth it for tiny files
+			for (auto encoding: { ENCODING_GZIP, ENCODING_BROTLI }) {
+				auto& variant = asset->content[encoding];
+				if (variant && variant->size() >= identity.size()) {
+					variant.reset();
+				}
+			}
+		}
+
+		const auto etag = Util::toString(aModified) + "-" + Util::toString(aSize) + "-" + Util::toString(aFileId);
+		asset->etags[ENCODING_IDENTITY] = "\"" + etag + "\"";
+		asset->etags[ENCODING_GZIP] = "\"" + etag + "-gz\"";
+		asset->etags[ENCODING_BROTLI] = "\"" + etag + "-br\"";
+
+		const auto tick = GET_TICK();
+		asset->lastChecked = tick;
+		asset->lastAccess = tick;
+		return asset;
+	}
+
+	AssetCache::Buffer AssetCache::loadPrecompressed(const string& aPath, time_t aModified) noexcept {
+		int64_t size = -1;
+		time_t modified = 0;
+		uint64_t fileId = 0;
+
+		// Don't use outdated variants
+		if (!FileServer::getFileInfo(aPath, size, modified, fileId) || size > MAX_ASSET_SIZE || modified < aModified) {
+			return nullptr;
+		}
+
+		try {
+			File f(aPath, File::READ, File::OPEN);
+			return std::make_shared<const string>(f.read());
+		} catch (const FileException&) {
+			return nullptr;
+		}
+	}
+
+	void AssetCache::compressGzipAsync(const AssetPtr& aAsset) noexcept {
+		WebServerManager::getInstance()->addAsyncTask([this, aAsset] {
+			const auto& identity = *aAsset->content[ENCODING_IDENTITY];
+			auto gzip = compressGzip(identity);
+			if (!gzip || gzip->size() >= identity.size()) {
+				return;
+			}
+
+			auto asset = std::make_shared<Asset>();
+			asset->path = aAsset->path;
+			asset->mimeType = aAsset->mimeType;
+			asset->lastModified = aAsset->lastModified;
+			asset->modified = aAsset->modified;
+			asset->size = aAsset->size;
+			asset->fileId = aAsset->fileId;
+			asset->content = aAsset->content;
+			asset->content[ENCODING_GZIP] = std::move(gzip);
+			asset->etags = aAsset->etags;
+			asset->lastChecked = aAsset->lastChecked.load();
+			asset->lastAccess = aAsset->lastAccess.load();
+
+			replaceAsset(aAsset, asset);
+		});
+	}
+
+	AssetCache::Buffer AssetCache::compressGzip(const string& aContent) noexcept {
+		z_stream zs;
+		memset(&zs, 0, sizeof(zs));
+
+		// Window bits + 16 produces a gzip header instead of the zlib one
+		// The default level is much faster than the best one while the output is only slightly larger
+		if (deflateInit2(&zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+			return nullptr;
+		}
+
+		string output;
+		output.resize(deflateBound(&zs, static_cast<uLong>(aContent.size())));
+
+		zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(aContent.data()));
+		zs.avail_in = static_cast<uInt>(aContent.size());
+		zs.next_out = reinterpret_cast<Bytef*>(output.data());
+		zs.avail_out = static_cast<uInt>(output.size());
+
+		auto ret = deflate(&zs, Z_FINISH);
+		output.resize(zs.total_out);
+		deflateEnd(&zs);
+
+		if (ret != Z_STREAM_END) {
+			return nullptr;
+		}
+
+		return std::make_shared<const string>(std::move(output));
+	}
+
+	bool AssetCache::isCompressible(const string& aPath) noexcept {
+		static const StringList compressibleTypes = { "js", "css", "html", "svg", "json", "map", "txt" };
+
+		const auto extension = HttpUtil::getExtension(aPath);
+		return ranges::find(compressibleTypes, extension) != compressibleTypes.end();
+	}
+
+	AssetCache::Encoding AssetCache::selectEncoding(const Asset& aAsset, const string& aAcceptEncoding) noexcept {
+		auto ret = ENCODING_IDENTITY;
+		if (aAcceptEncoding.empty()) {
+			return ret;
+		}
+
+		for (auto encoding: { ENCODING_BROTLI, ENCODING_GZIP }) {
+			const auto& variant = aAsset.content[encoding];
+			if (!variant || variant->size() >= aAsset.content[ret]->size()) {
+				continue;
+			}
+
+			if (HttpUtil::acceptsEncoding(aAcceptEncoding, getEncodingName(encoding))) {
+				ret = encoding;
+			}
+		}
+
+		return ret;
+	}
+
+	const char* AssetCache::getEncodingName(Encoding aEncoding) noexcept {
+		switch (aEncoding) {
+			case ENCODING_GZIP: return "gzip";
+			case ENCODING_BROTLI: return "br";
+			default: return "identity";
+		}
+	}
+
+	void AssetCache::addAsset(const AssetPtr& aAsset) noexcept {
+		const auto assetSize = aAsset->getMemoryUsage();
+
+		WLock l(cs);
+		auto& current = assets[aAsset->path];
+		if (current) {
+			totalSize -= current->getMemoryUsage();
+		}
+
+		current = aAsset;
+		totalSize += assetSize;
+
+		if (totalSize > MAX_CACHE_SIZE) {
+			evictUnsafe(MAX_CACHE_SIZE);
+		}
+	}
+
+	void AssetCache::replaceAsset(const AssetPtr& aOld, const AssetPtr& aNew) noexcept {
+		const auto assetSize = aNew->getMemoryUsage();
+
+		WLock l(cs);
+		auto i = assets.find(aNew->path);
+		if (i == assets.end() || i->second != aOld) {
+			return;
+		}
+
+		totalSize -= aOld->getMemoryUsage();
+		i->second = aNew;
+		totalSize += assetSize;
+
+		if (totalSize > MAX_CACHE_SIZE) {
+			evictUnsafe(MAX_CACHE_SIZE);
+		}
+	}
+
+	void AssetCache::removeAsset(const string& aPath) noexcept {
+		WLock l(cs);
+		auto i = assets.find(aPath);
+		if (i != assets.end()) {
+			totalSize -= i->second->getMemoryUsage();
+			assets.erase(i);
+		}
+	}
+
+	void AssetCache::evictUnsafe(size_t aMaxSize) noexcept {
+		// Eviction is rare (the UI is much smaller than the cache size limit) so a linear scan will do
+		while (totalSize > aMaxSize && !assets.empty()) {
+			auto lru = ranges::min_element(assets, [](const auto& a, const auto& b) {
+				return a.second->lastAccess < b.second->lastAccess;
+			});
+
+			totalSize -= lru->second->getMemoryUsage();
+			assets.erase(lru);
+			evictions++;
+		}
+	}
+
+	void AssetCache::clear() noexcept {
+		WLock l(cs);
+		assets.clear();
+		totalSize = 0;
+	}
+
+	AssetCache::Stats AssetCache::getStats() const noexcept {
+		RLock l(cs);
+		return {
+			hits,
+			misses,
+			evictions,
+			assets.size(),
+			totalSize,
+		};
+	}
+}
@@ -0,0 +1,130 @@
+/*
+* Copyright (C) 2011-2024 AirDC++ Project
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+*/
+
+#ifndef DCPLUSPLUS_WEBSERVER_ASSETCACHE_H
+#define DCPLUSPLUS_WEBSERVER_ASSETCACHE_H
+
+#include "forward.h"
+
+#include <airdcpp/core/header/typedefs.h>
+#include <airdcpp/core/thread/CriticalSection.h>
+
+#include <array>
+#include <atomic>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace webserver {
+	// Size-bounded in-memory cache for the Web UI resources
+	// Compressed variants, ETags and MIME types are prepared when the file is loaded (gzip variants that aren't provided by the UI build
+	// are generated in a task thread) so that serving an asset doesn't require any file access (changed files are detected by polling the file metadata)
+	class AssetCache {
+	public:
+		enum Encoding : uint8_t {
+			ENCODING_IDENTITY,
+			ENCODING_GZIP,
+			ENCODING_BROTLI,
+			ENCODING_LAST
+		};
+
+		using Buffer = std::shared_ptr<const string>;
+
+		struct Asset {
+			string path;
+			const char* mimeType = nullptr;
+			string lastModified;
+
+			time_t modified = 0;
+			int64_t size = 0;
+			uint64_t fileId = 0;
+
+			// Content and strong ETag for each encoding (compressed variants are empty if they are not available)
+			std::array<Buffer, ENCODING_LAST> content;
+			std::array<string, ENCODING_LAST> etags;
+
+			// Ticks
+			mutable std::atomic<uint64_t> lastChecked { 0 };
+			mutable std::atomic<uint64_t> lastAccess { 0 };
+
+			bool hasCompressedVariants() const noexcept {
+				return content[ENCODING_GZIP] || content[ENCODING_BROTLI];
+			}
+
+			size_t getMemoryUsage() const noexcept;
+		};
+
+		using AssetPtr = std::shared_ptr<const Asset>;
+
+		struct Stats {
+			uint64_t hits = 0;
+			uint64_t misses = 0;
+			uint64_t evictions = 0;
+
+			size_t assets = 0;
+			size_t bytes = 0;
+		};
+
+		AssetCache() = default;
+
+		// Returns the cached asset (the file is loaded if it's not cached or it has been modified)
+		// nullptr is returned if the file doesn't exist, it's too large to be cached or it's being loaded by another request
+		// Missing gzip variants are generated in the background and they are available for the following requests
+		AssetPtr getAsset(const string& aPath) noexcept;
+
+		// Picks the smallest available variant that is accepted by the client
+		static Encoding selectEncoding(const Asset& aAsset, const string& aAcceptEncoding) noexcept;
+		static const char* getEncodingName(Encoding aEncoding) noexcept;
+
+		void clear() noexcept;
+		Stats getStats() const noexcept;
+
+		AssetCache(AssetCache&) = delete;
+		AssetCache& operator=(AssetCache&) = delete;
+	private:
+		// compressGzip_ is set if the gzip variant should be generated
+		static AssetPtr loadAsset(const string& aPath, int64_t aSize, time_t aModified, uint64_t aFileId, bool& compressGzip_);
+		static Buffer loadPrecompressed(const string& aPath, time_t aModified) noexcept;
+		static Buffer compressGzip(const string& aContent) noexcept;
+		static bool isCompressible(const string& aPath) noexcept;
+
+		// Compresses the asset in a task thread and replaces the cached asset with one having the gzip variant
+		void compressGzipAsync(const AssetPtr& aAsset) noexcept;
+
+		void addAsset(const AssetPtr& aAsset) noexcept;
+		void removeAsset(const string& aPath) noexcept;
+
+		// The asset is replaced only if it hasn't been changed or removed meanwhile
+		void replaceAsset(const AssetPtr& aOld, const AssetPtr& aNew) noexcept;
+
+		// Removes the least recently used assets until the cache size is below the limit
+		void evictUnsafe(size_t aMaxSize) noexcept;
+
+		mutable SharedMutex cs;
+		std::unordered_map<string, AssetPtr> assets;
+		size_t totalSize = 0;
+
+		// Paths that are currently being loaded by a request
+		std::unordered_set<string> loadingPaths;
+
+		std::atomic<uint64_t> hits { 0 };
+		std::atomic<uint64_t> misses { 0 };
+		uint64_t evictions = 0;
+	};
+}
+
+#endif
@@ -0,0 +1,89 @@
+/*
+* Copyright (C) 2011-2024 AirDC++ Project
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+*/
+
+#ifndef DCPLUSPLUS_WEBSERVER_BEAST_FILE_RANGE_BODY_H
+#define DCPLUSPLUS_WEBSERVER_BEAST_FILE_RANGE_BODY_H
+
+#include <boost/beast/core/file.hpp>
+#include <boost/beast/http/error.hpp>
+#include <boost/beast/http/message.hpp>
+#include <boost/optional.hpp>
+
+#include <algorithm>
+#include <cstdint>
+
+namespace webserver {
+	// Beast body serializing a byte range of an open file in fixed-size chunks
+	// (memory usage doesn't depend on the size of the file)
+	struct BeastFileRangeBody {
+		static constexpr std::size_t CHUNK_SIZE = 64 * 1024;
+
+		struct value_type {
+			boost::beast::file file;
+			std::uint64_t start = 0;
+			std::uint64_t length = 0;
+		};
+
+		static std::uint64_t size(const value_type& aBody) {
+			return aBody.length;
+		}
+
+		class writer {
+		public:
+			using const_buffers_type = boost::asio::const_buffer;
+
+			template<bool isRequest, class Fields>
+			writer(boost::beast::http::header<isRequest, Fields>&, value_type& aBody) : body(aBody) {
+
+			}
+
+			void init(boost::beast::error_code& ec) {
+				body.file.seek(body.start, ec);
+				remain = body.length;
+			}
+
+			boost::optional<std::pair<const_buffers_type, bool>> get(boost::beast::error_code& ec) {
+				const auto amount = static_cast<std::size_t>(std::min<std::uint64_t>(remain, CHUNK_SIZE));
+				if (amount == 0) {
+					ec = {};
+					return boost::none;
+				}
+
+				const auto bytesRead = body.file.read(buf, amount, ec);
+				if (ec) {
+					return boost::none;
+				}
+
+				if (bytesRead == 0) {
+					// File was truncated
+					ec = boost::beast::http::error::short_read;
+					return boost::none;
+				}
+
+				remain -= bytesRead;
+				return { { const_buffers_type(buf, bytesRead), remain > 0 } };
+			}
+		private:
+			value_type& body;
+			std::uint64_t remain = 0;
+			char buf[CHUNK_SIZE];
+		};
+	};
+}
+
+#endif // DCPLUSPLUS_WEBSERVER_BEAST_FILE_RANGE_BODY_H
@@ -4,29 +4,46 @@
 
 #include "stdinc.h"
 #include "IServerEndpoint.h"
+#include "BeastFileRangeBody.h"
 
 #include <boost/asio/ip/tcp.hpp>
 #include <boost/asio/dispatch.hpp>
 #include <boost/asio/post.hpp>
 #include <boost/asio/strand.hpp>
 #include <boost/asio/signal_set.hpp>
+#include <boost/asio/steady_timer.hpp>
 #include <boost/beast/core.hpp>
 #include <boost/beast/http.hpp>
+#include <boost/beast/ssl.hpp>
 #include <boost/beast/version.hpp>
+#include <boost/version.hpp>
 #include <boost/beast/websocket.hpp>
+#include <boost/beast/websocket/ssl.hpp>
 
+#include <airdcpp/core/io/File.h>
+
+#include <algorithm>
+#include <atomic>
 #include <memory>
 #include <optional>
 #include <unordered_map>
 #include <deque>
+#include <list>
 #include <mutex>
 
+#ifdef __linux__
+#include <sys/sendfile.h>
+#endif
+
 namespace webserver {
 	namespace beast = boost::beast;
 	namespace http = beast::http;
 	namespace websocket = beast::websocket;
 	using tcp = boost::asio::ip::tcp;
 
+	using PlainStream = beast::tcp_stream;
+	using TlsStream = beast::ssl_stream<beast::tcp_stream>;
+
 	class BeastServerAdapter : public IServerEndpoint, public std::enable_shared_from_this<BeastServerAdapter> {
 	public:
 		BeastServerAdapter() = default;
@@ -35,9 +52,36 @@ namespace webserver {
 		// IServerEndpoint
 		void initAsio(boost::asio::io_context* ios) override { ios_ = ios; }
 		void setOpenHandshakeTimeout(int) override {}
-		void setPongTimeout(int) override {}
-		void setMaxHttpBodySize(std::size_t) override {}
-		void setTlsInitHandler(std::function<contextPtr()>) override {}
+		void setPongTimeout(int millis) override { pongTimeout_ = millis; }
+		void setMaxHttpBodySize(std::size_t bytes) override { maxHttpBodySize_ = bytes; }
+		void setMaxHttpUploadSize(std::uint64_t bytes) override { maxHttpUploadSize_ = bytes; }
+		void setHttpBodyFileHandler(std::function<std::string(ConnectionHdl)> f) override { onHttpBodyFile_ = std::move(f); }
+		void setHttpKeepAlive(int idleTimeoutMillis, int maxRequests) override {
+			keepAliveTimeout_ = idleTimeoutMillis;
+			keepAliveMaxRequests_ = maxRequests;
+		}
+		void setWsCompression(int windowBits, int memLevel, std::size_t minMessageSize) override {
+			// Beast throws for window bits outside 9-15 (keep the previous valid value when compression is disabled)
+			wsDeflate_.server_enable = windowBits > 0;
+			if (wsDeflate_.server_enable) {
+				wsDeflate_.server_max_window_bits = std::clamp(windowBits, 9, 15);
+			}
+
+			wsDeflate_.memLevel = memLevel;
+#if BOOST_VERSION >= 108100
+			wsDeflate_.msg_size_threshold = minMessageSize;
+#else
+			// Not supported by older Beast versions, all messages are compressed
+			(void)minMessageSize;
+#endif
+		}
+		void setWsSubprotocols(const std::vector<std::string>& subprotocols) override { wsSubprotocols_ = subprotocols; }
+		void setWsSendQueueLimits(std::size_t maxBytes, std::size_t maxMessages, WsSendQueuePolicy policy) override {
+			wsQueueMaxBytes_ = maxBytes;
+			wsQueueMaxMessages_ = maxMessages;
+			wsQueuePolicy_ = policy;
+		}
+		void setTlsInitHandler(std::function<contextPtr()> f) override { tlsInitHandler_ = std::move(f); }
 		void configureLogging(std::ostream* access, std::ostream* error, bool enable) override {
 			std::lock_guard<std::mutex> lk(logMutex_);
 			accessLog_ = access;
@@ -74,7 +118,7 @@ namespace webserver {
 			}
 		}
 
-		void setMessageHandler(std::function<void(ConnectionHdl, const std::string&)> f) override { onMessage_ = std::move(f); }
+		void setMessageHandler(std::function<void(ConnectionHdl, std::string_view)> f) override { onMessage_ = std::move(f); }
 		void setHttpHandler(std::function<void(ConnectionHdl)> f) override { onHttp_ = std::move(f); }
 		void setCloseHandler(std::function<void(ConnectionHdl)> f) override { onClose_ = std::move(f); }
 		void setOpenHandler(std::function<void(ConnectionHdl)> f) override { onOpen_ = std::move(f); }
@@ -97,6 +141,10 @@ namespace webserver {
 			if (auto s = lockHttp(hdl)) return std::string(s->req.body());
 			return {};
 		}
+		std::string getBodyFilePath(ConnectionHdl hdl) override {
+			if (auto s = lockHttp(hdl)) return s->bodyFile;
+			return {};
+		}
 		std::string getMethod(ConnectionHdl hdl) override {
 			if (auto s = lockHttp(hdl)) return std::string(s->req.method_string());
 			if (auto ws = lockWs(hdl)) return ws->methodStr; // usually GET
@@ -112,6 +160,10 @@ namespace webserver {
 			else if (auto ws = lockWs(hdl)) return ws->target;
 			return "";
 		}
+		std::string getWsSubprotocol(ConnectionHdl hdl) override {
+			if (auto ws = lockWs(hdl)) return ws->subprotocol;
+			return {};
+		}
 
 		void httpAppendHeader(ConnectionHdl hdl, const std::string& name, const std::string& value) override {
 			if (auto s = lockHttp(hdl)) s->respHeaders.emplace_back(name, value);
@@ -119,21 +171,45 @@ namespace webserver {
 		void httpSetBody(ConnectionHdl hdl, const std::string& body) override {
 			if (auto s = lockHttp(hdl)) s->respBody = body;
 		}
+		void httpSetFileBody(ConnectionHdl hdl, const HttpFileBody& body) override {
+			if (auto s = lockHttp(hdl)) s->respFile = body;
+		}
 		void httpSetStatus(ConnectionHdl hdl, http::status status) override {
 			if (auto s = lockHttp(hdl)) s->respStatus = status;
 		}
 		void httpDeferResponse(ConnectionHdl hdl) override {
-			if (auto s = lockHttp(hdl)) s->markDeferred();
+			if (auto s = lockHttp(hdl)) {
+				s->deferred = true;
+				logAccess("HTTP deferred response");
+			}
 		}
 		void httpSendResponse(ConnectionHdl hdl) override {
-			if (auto s = lockHttp(hdl)) s->sendAndRelease();
+			if (auto s = lockHttp(hdl)) {
+				if (auto connection = s->connection) {
+					connection->onResponseReady(s);
+				}
+			}
 		}
 
-		void wsSendText(ConnectionHdl hdl, const std::string& text) override {
+		void wsSendText(ConnectionHdl hdl, std::string&& text, const WsMessageInfo& info) override {
 			if (auto s = lockWs(hdl)) {
-				s->sendText(text);
+				s->sendText(std::make_shared<const std::string>(std::move(text)), info);
 			}
 		}
+		void wsSendShared(ConnectionHdl hdl, const std::shared_ptr<const std::string>& text, const WsMessageInfo& info) override {
+			if (auto s = lockWs(hdl)) {
+				s->sendText(text, info);
+			}
+		}
+		WsSendQueueStats getWsSendQueueStats() const noexcept override {
+			WsSendQueueStats stats;
+			stats.queuedMessages = wsQueuedMessages_;
+			stats.queuedBytes = wsQueuedBytes_;
+			stats.coalescedMessages = wsCoalescedMessages_;
+			stats.droppedMessages = wsDroppedMessages_;
+			stats.disconnectedClients = wsQueueDisconnects_;
+			return stats;
+		}
 		void wsPing(ConnectionHdl hdl) override {
 			if (auto s = lockWs(hdl)) {
 				s->sendPing();
@@ -163,112 +239,645 @@ namespace webserver {
 			std::string remoteIp;
 		};
 
-		struct HttpSession : public SessionBase, public std::enable_shared_from_this<HttpSession> {
-			HttpSession(BeastServerAdapter& owner, tcp::socket&& socket, const std::string& ip)
-				: adapter(owner), stream(std::move(socket)) {
+		static ConnectionHdl makeHandle(const std::shared_ptr<SessionBase>& s) {
+			std::weak_ptr<void> w = std::static_pointer_cast<void>(s);
+			return w;
+		}
+
+		struct HttpExchange;
+		using HttpExchangePtr = std::shared_ptr<HttpExchange>;
+
+		struct HttpConnection {
+			virtual ~HttpConnection() = default;
+
+			// Thread-safe, may be called from the task threads with deferred responses
+			virtual void onResponseReady(const HttpExchangePtr& aExchange) = 0;
+		};
+
+		// A single request/response pair on a (possibly persistent) HTTP connection
+		// The connection handle passed to the HTTP handler points to this object
+		struct HttpExchange : public SessionBase {
+			HttpExchange(http::request<http::string_body>&& aReq, const std::string& ip) : req(std::move(aReq)) {
 				remoteIp = ip;
 			}
 
+			http::request<http::string_body> req;
+			http::status respStatus = http::status::ok;
+			std::vector<std::pair<std::string,std::string>> respHeaders;
+			std::string respBody;
+			std::optional<HttpFileBody> respFile;
+
+			// Path of the file where the request body was written (if it wasn't read in memory)
+			std::string bodyFile;
+			bool keepAlive = false;
+			bool deferred = false;
+
+			// Response can be written (accessed only from the connection executor)
+			bool ready = false;
+
+			// Keeps the connection alive while the response is pending
+			std::shared_ptr<HttpConnection> connection;
+		};
+
+		// Persistent HTTP connection (Stream is either PlainStream or TlsStream)
+		// Requests are read ahead (pipelined) while earlier responses are still pending;
+		// responses are always written in the order the requests were received
+		template<class Stream>
+		struct HttpSession : public HttpConnection, public std::enable_shared_from_this<HttpSession<Stream>> {
+			static constexpr bool IS_TLS = std::is_same_v<Stream, TlsStream>;
+
+			HttpSession(BeastServerAdapter& owner, Stream&& aStream, const std::string& ip, const contextPtr& aTlsContext)
+				: adapter(owner), tlsContext(aTlsContext), stream(std::move(aStream)), idleTimer(stream.get_executor()), writeTimer(stream.get_executor()), remoteIp(ip) {
+			}
+
 			void run() {
-				auto self = shared_from_this();
-				http::async_read(stream, buffer, req,
-					[self](beast::error_code ec, std::size_t) {
-					static_cast<HttpSession*>(self.get())->onRead(ec);
+				if constexpr (IS_TLS) {
+					beast::get_lowest_layer(stream).expires_after(std::chrono::seconds(TLS_HANDSHAKE_TIMEOUT));
+					stream.async_handshake(boost::asio::ssl::stream_base::server, [self = this->shared_from_this()](beast::error_code ec) {
+						if (ec) {
+							self->adapter.logError("TLS handshake error: " + ec.message());
+							return;
+						}
+
+						self->doRead();
+					});
+				} else {
+					doRead();
+				}
+			}
+
+			tcp::socket& socket() {
+				return beast::get_lowest_layer(stream).socket();
+			}
+
+			void doRead() {
+				reading = true;
+				headerParser.emplace();
+
+				// Only writes have a timeout, idle connections are handled by idleTimer
+				beast::get_lowest_layer(stream).expires_never();
+				if (pending.empty()) {
+					armIdleTimer();
+				}
+
+				http::async_read_header(stream, buffer, *headerParser, beast::bind_front_handler(&HttpSession::onReadHeader, this->shared_from_this()));
+			}
+
+			void onReadHeader(beast::error_code ec, std::size_t) {
+				idleTimer.cancel();
+				if (ec) {
+					onReadFailed(ec);
+					return;
+				}
+
+				const auto& header = headerParser->get();
+				const auto contentLength = headerParser->content_length();
+				const auto hasBody = contentLength.value_or(0) > 0 || headerParser->chunked();
+
+				// Let the handler decide whether the body should be written directly on disk
+				if (hasBody && adapter.onHttpBodyFile_ && !websocket::is_upgrade(header)) {
+					auto exchange = std::make_shared<HttpExchange>(http::request<http::string_body>(header.base()), remoteIp);
+					auto filePath = adapter.onHttpBodyFile_(makeHandle(std::static_pointer_cast<SessionBase>(exchange)));
+					if (!filePath.empty()) {
+						readFileBody(exchange, filePath);
+						return;
+					}
+				}
+
+				if (contentLength && *contentLength > adapter.maxHttpBodySize_) {
+					respondError(http::status::payload_too_large, "Request body is too large");
+					return;
+				}
+
+				bodyParser.emplace(std::move(*headerParser));
+				headerParser.reset();
+				bodyParser->body_limit(adapter.maxHttpBodySize_);
+
+				readBody(*bodyParser, [self = this->shared_from_this()](beast::error_code ec, std::size_t) {
+					if (ec) {
+						self->onReadFailed(ec);
+						return;
+					}
+
+					auto exchange = std::make_shared<HttpExchange>(self->bodyParser->release(), self->remoteIp);
+					self->bodyParser.reset();
+					self->onRequest(exchange);
 				});
 			}
 
-			void onRead(beast::error_code ec) {
+			void readFileBody(const HttpExchangePtr& aExchange, const std::string& aFilePath) {
+				const auto contentLength = headerParser->content_length();
+				if (contentLength && *contentLength > adapter.maxHttpUploadSize_) {
+					respondError(http::status::payload_too_large, "Uploaded file is too large");
+					return;
+				}
+
+				fileParser.emplace(std::move(*headerParser));
+				headerParser.reset();
+				fileParser->body_limit(adapter.maxHttpUploadSize_);
+
+				beast::error_code ec;
+				fileParser->get().body().open(aFilePath.c_str(), beast::file_mode::write, ec);
 				if (ec) {
-					adapter.logError("HTTP read error: " + ec.message());
+					adapter.logError("HTTP failed to open " + aFilePath + " for writing: " + ec.message());
+					fileParser.reset();
+					respondError(http::status::internal_server_error, "Failed to create the file: " + ec.message());
+					return;
+				}
+
+				aExchange->bodyFile = aFilePath;
+				readBody(*fileParser, [self = this->shared_from_this(), aExchange](beast::error_code ec, std::size_t) {
+					// Close the file
+					self->fileParser.reset();
+
+					if (ec) {
+						dcpp::File::deleteFile(aExchange->bodyFile);
+						self->onReadFailed(ec);
+						return;
+					}
+
+					self->onRequest(aExchange);
+				});
+			}
+
+			template<class Parser, class Handler>
+			void readBody(Parser& aParser, Handler&& aHandler) {
+				if (aParser.is_done()) {
+					aHandler(beast::error_code(), 0);
 					return;
 				}
 
-				adapter.logAccess("HTTP request " + std::string(req.method_string()) + " " + std::string(req.target()));
+				auto readF = [this, &aParser, self = this->shared_from_this(), handler = std::forward<Handler>(aHandler)]() mutable {
+					http::async_read(stream, buffer, aParser, std::move(handler));
+				};
 
-				if (websocket::is_upgrade(req)) {
-					// Upgrade to websocket
-					auto wsSession = std::make_shared<WsSession>(adapter, stream.release_socket(), remoteIp);
-					auto h = makeHandle(std::static_pointer_cast<SessionBase>(wsSession));
-					wsSession->doAccept(std::move(req), h);
+				// Responses can't be interleaved with the 100 Continue message
+				const auto expectContinue = beast::iequals(aParser.get()[http::field::expect], "100-continue");
+				if (!expectContinue || writing || !pending.empty()) {
+					readF();
 					return;
 				}
 
-				hdl = makeHandle(std::static_pointer_cast<SessionBase>(this->shared_from_this()));
+				// Let the client know that the body can be sent
+				continueRes = std::make_shared<http::response<http::empty_body>>(http::status::continue_, aParser.get().version());
+				writing = true;
+				http::async_write(stream, *continueRes, [self = this->shared_from_this(), readF = std::move(readF)](beast::error_code ec, std::size_t) mutable {
+					self->writing = false;
+					self->continueRes.reset();
+					if (ec) {
+						self->onReadFailed(ec);
+						return;
+					}
+
+					readF();
+				});
+			}
+
+			void onReadFailed(beast::error_code ec) {
+				reading = false;
+				headerParser.reset();
+				bodyParser.reset();
+
+				if (ec == http::error::body_limit) {
+					respondError(http::status::payload_too_large, "Request body is too large");
+					return;
+				}
+
+				if (ec != http::error::end_of_stream && ec != boost::asio::error::operation_aborted) {
+					adapter.logError("HTTP read error: " + ec.message());
+				}
+
+				closing = true;
+				closeIfIdle();
+			}
+
+			// Send an error response and close the connection (the request body won't be read)
+			void respondError(http::status aStatus, const std::string& aMessage) {
+				reading = false;
+				headerParser.reset();
+
+				auto exchange = std::make_shared<HttpExchange>(http::request<http::string_body>(), remoteIp);
+				exchange->respStatus = aStatus;
+				exchange->respBody = aMessage;
+				exchange->ready = true;
+				exchange->connection = this->shared_from_this();
+				pending.push_back(exchange);
+
+				closing = true;
+				flush();
+			}
+
+			void onRequest(const HttpExchangePtr& exchange) {
+				reading = false;
+
+				requestCount++;
+				adapter.logAccess("HTTP request " + std::string(exchange->req.method_string()) + " " + std::string(exchange->req.target()));
+
+				if (websocket::is_upgrade(exchange->req)) {
+					// Upgrade to websocket once all earlier responses have been sent
+					upgradeReq = std::move(exchange->req);
+					if (pending.empty() && !writing) {
+						doUpgrade();
+					}
+
+					return;
+				}
+
+				exchange->keepAlive = exchange->req.keep_alive() && adapter.keepAliveTimeout_ > 0 &&
+					(adapter.keepAliveMaxRequests_ <= 0 || requestCount < adapter.keepAliveMaxRequests_);
+				exchange->connection = this->shared_from_this();
+				pending.push_back(exchange);
+
+				if (!exchange->keepAlive) {
+					// This is the last request that will be handled for this connection
+					closing = true;
+				}
 
 				if (adapter.onHttp_) {
-					adapter.onHttp_(hdl);
+					adapter.onHttp_(makeHandle(std::static_pointer_cast<SessionBase>(exchange)));
 				}
 
-				if (!deferred) {
-					sendResponse();
+				if (!exchange->deferred) {
+					exchange->ready = true;
 				}
+
+				flush();
+				readNext();
 			}
 
-			// keep the session alive while deferred
-			void markDeferred() {
-				if (!deferred) {
-					deferred = true;
-					selfKeep = shared_from_this();
-					adapter.logAccess("HTTP deferred response");
+			// Continue reading pipelined requests if the queue isn't full
+			void readNext() {
+				if (reading || closing || upgradeReq || pending.size() >= MAX_PIPELINED_REQUESTS) {
+					return;
 				}
+
+				doRead();
 			}
 
-			void sendAndRelease() {
-				sendResponse();
-				deferred = false;
-				selfKeep.reset();
+			void onResponseReady(const HttpExchangePtr& aExchange) override {
+				boost::asio::post(stream.get_executor(), [self = this->shared_from_this(), aExchange] {
+					aExchange->ready = true;
+					self->flush();
+				});
 			}
 
-			void sendResponse() {
-				auto beastStatus = static_cast<http::status>(static_cast<unsigned>(respStatus));
-				respPtr = std::make_shared<http::response<http::string_body>>(beastStatus, req.version());
-				respPtr->set(http::field::server, "airdcpp-beast");
-				for (const auto& [k,v] : respHeaders) respPtr->set(k, v);
-				respPtr->body() = respBody;
+			void flush() {
+				if (writing || pending.empty() || !pending.front()->ready) {
+					return;
+				}
+
+				writing = true;
+
+				auto& exchange = *pending.front();
+				if (exchange.req.method() == http::verb::head) {
+					writeHeadResponse(exchange);
+					return;
+				}
+
+				if (exchange.respFile && exchange.respFile->buffer) {
+					writeBufferResponse(exchange);
+					return;
+				}
+
+				if (exchange.respFile && writeFileResponse(exchange)) {
+					return;
+				}
+
+				respPtr = std::make_shared<http::response<http::string_body>>();
+				prepareResponse(*respPtr, exchange);
+				respPtr->body() = std::move(exchange.respBody);
 				respPtr->prepare_payload();
 
-				adapter.logAccess("HTTP response " + std::to_string(static_cast<unsigned>(respStatus)) + " bytes=" + std::to_string(respPtr->body().size()));
+				adapter.logAccess("HTTP response " + std::to_string(static_cast<unsigned>(exchange.respStatus)) + " bytes=" + std::to_string(respPtr->body().size()));
 
-				auto self = shared_from_this();
-				http::async_write(stream, *respPtr, [self](beast::error_code ec, std::size_t /*bytes*/){
-					auto* p = static_cast<HttpSession*>(self.get());
-					if (ec) {
-						p->adapter.logError("HTTP write error: " + ec.message());
+				beast::get_lowest_layer(stream).expires_after(std::chrono::seconds(HTTP_WRITE_TIMEOUT));
+				http::async_write(stream, *respPtr, beast::bind_front_handler(&HttpSession::onWrite, this->shared_from_this()));
+			}
+
+			// Headers only, the length is reported as it would be for GET
+			void writeHeadResponse(HttpExchange& aExchange) {
+				headRes = std::make_shared<http::response<http::empty_body>>();
+				prepareResponse(*headRes, aExchange);
+				if (aExchange.respStatus != http::status::not_modified && aExchange.respStatus != http::status::no_content) {
+					headRes->content_length(aExchange.respFile ? aExchange.respFile->length : aExchange.respBody.size());
+				}
+
+				adapter.logAccess("HTTP response " + std::to_string(static_cast<unsigned>(aExchange.respStatus)) + " (HEAD)");
+
+				beast::get_lowest_layer(stream).expires_after(std::chrono::seconds(HTTP_WRITE_TIMEOUT));
+				http::async_write(stream, *headRes, beast::bind_front_handler(&HttpSession::onWrite, this->shared_from_this()));
+			}
+
+			template<class Body>
+			static void prepareResponse(http::response<Body>& res, const HttpExchange& aExchange) {
+				res.result(static_cast<http::status>(static_cast<unsigned>(aExchange.respStatus)));
+				res.version(aExchange.req.version());
+				res.set(http::field::server, "airdcpp-beast");
+				for (const auto& [k,v] : aExchange.respHeaders) res.set(k, v);
+				res.keep_alive(aExchange.keepAlive);
+			}
+
+			// Cached content is referenced directly (the exchange keeps the buffer alive until the write has completed)
+			void writeBufferResponse(HttpExchange& aExchange) {
+				const auto& fileInfo = *aExchange.respFile;
+
+				bufferRes = std::make_shared<http::response<http::span_body<const char>>>();
+				prepareResponse(*bufferRes, aExchange);
+				bufferRes->body() = boost::beast::span<const char>(fileInfo.buffer->data() + fileInfo.start, static_cast<std::size_t>(fileInfo.length));
+				bufferRes->prepare_payload();
+
+				adapter.logAccess("HTTP response " + std::to_string(static_cast<unsigned>(aExchange.respStatus)) + " cached bytes=" + std::to_string(fileInfo.length));
+
+				beast::get_lowest_layer(stream).expires_after(std::chrono::seconds(HTTP_WRITE_TIMEOUT));
+				http::async_write(stream, *bufferRes, beast::bind_front_handler(&HttpSession::onWrite, this->shared_from_this()));
+			}
+
+			// Returns false if the file couldn't be opened (an error response is set for the exchange in that case)
+			bool writeFileResponse(HttpExchange& aExchange) {
+				const auto& fileInfo = *aExchange.respFile;
+
+				fileRes = std::make_shared<http::response<BeastFileRangeBody>>();
+				prepareResponse(*fileRes, aExchange);
+
+				beast::error_code ec;
+				auto& body = fileRes->body();
+				body.file.open(fileInfo.path.c_str(), beast::file_mode::scan, ec);
+				if (ec) {
+					adapter.logError("HTTP failed to open " + fileInfo.path + ": " + ec.message());
+					fileRes.reset();
+
+					aExchange.respFile.reset();
+					aExchange.respStatus = http::status::not_found;
+					aExchange.respHeaders.clear();
+					aExchange.respBody = ec.message();
+					return false;
+				}
+
+				body.start = static_cast<std::uint64_t>(fileInfo.start);
+				body.length = static_cast<std::uint64_t>(fileInfo.length);
+				fileRes->prepare_payload();
+
+				adapter.logAccess("HTTP response " + std::to_string(static_cast<unsigned>(aExchange.respStatus)) + " file bytes=" + std::to_string(body.length));
+
+				fileSerializer = std::make_shared<http::response_serializer<BeastFileRangeBody>>(*fileRes);
+
+#ifdef __linux__
+				if (!IS_TLS && body.length > 0) {
+					// Write the header normally and let the kernel send the file content
+					beast::get_lowest_layer(stream).expires_after(std::chrono::seconds(HTTP_WRITE_TIMEOUT));
+					http::async_write_header(stream, *fileSerializer, [self = this->shared_from_this()](beast::error_code ec, std::size_t) {
+						if (ec) {
+							self->onWrite(ec, 0);
+							return;
+						}
+
+						self->sendFileContent();
+					});
+
+					return true;
+				}
+#endif
+
+				writeFileChunk();
+				return true;
+			}
+
+			// Write timeout is renewed after each chunk so that large files won't time out
+			void writeFileChunk() {
+				beast::get_lowest_layer(stream).expires_after(std::chrono::seconds(HTTP_WRITE_TIMEOUT));
+				http::async_write_some(stream, *fileSerializer, [self = this->shared_from_this()](beast::error_code ec, std::size_t) {
+					if (ec || self->fileSerializer->is_done()) {
+						self->onWrite(ec, 0);
+						return;
 					}
-					p->respPtr.reset();
-					p->doClose();
+
+					self->writeFileChunk();
 				});
 			}
 
-			void doClose() {
+#ifdef __linux__
+			void sendFileContent() {
+				auto& body = fileRes->body();
+				auto& socket = this->socket();
+
 				beast::error_code ec;
-				stream.socket().shutdown(tcp::socket::shutdown_send, ec);
+				socket.native_non_blocking(true, ec);
+				if (ec) {
+					onWrite(ec, 0);
+					return;
+				}
+
+				for (;;) {
+					const auto remaining = body.length - sendfileOffset;
+					if (remaining == 0) {
+						onWrite({}, 0);
+						return;
+					}
+
+					off_t offset = static_cast<off_t>(body.start + sendfileOffset);
+					const auto sent = ::sendfile(socket.native_handle(), body.file.native_handle(), &offset, static_cast<size_t>(std::min<std::uint64_t>(remaining, SENDFILE_CHUNK_SIZE)));
+					if (sent > 0) {
+						sendfileOffset += static_cast<std::uint64_t>(sent);
+						continue;
+					}
+
+					if (sent < 0 && errno == EINTR) {
+						continue;
+					}
+
+					if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+						// Wait until the socket is writable again
+						writeTimer.expires_after(std::chrono::seconds(HTTP_WRITE_TIMEOUT));
+						writeTimer.async_wait([self = this->shared_from_this()](beast::error_code ec) {
+							if (ec != boost::asio::error::operation_aborted) {
+								beast::error_code ignored;
+								self->socket().cancel(ignored);
+							}
+						});
+
+						socket.async_wait(tcp::socket::wait_write, [self = this->shared_from_this()](beast::error_code ec) {
+							self->writeTimer.cancel();
+							if (ec) {
+								self->onWrite(ec, 0);
+								return;
+							}
+
+							self->sendFileContent();
+						});
+
+						return;
+					}
+
+					// File was truncated or the connection failed
+					onWrite(sent == 0 ? beast::error_code(http::error::short_read) : beast::error_code(errno, boost::system::system_category()), 0);
+					return;
+				}
+			}
+#endif
+
+			void onWrite(beast::error_code ec, std::size_t /*bytes*/) {
+				writing = false;
+				respPtr.reset();
+				headRes.reset();
+				bufferRes.reset();
+				fileSerializer.reset();
+				fileRes.reset();
+				sendfileOffset = 0;
+
+				auto exchange = std::move(pending.front());
+				pending.pop_front();
+				exchange->connection.reset();
+
+				if (ec) {
+					adapter.logError("HTTP write error: " + ec.message());
+					abort();
+					return;
+				}
+
+				if (!exchange->keepAlive) {
+					abort();
+					return;
+				}
+
+				if (pending.empty() && upgradeReq) {
+					doUpgrade();
+					return;
+				}
+
+				flush();
+				readNext();
+
+				if (reading && pending.empty()) {
+					armIdleTimer();
+				}
+
+				closeIfIdle();
+			}
+
+			void armIdleTimer() {
+				if (adapter.keepAliveTimeout_ <= 0) {
+					return;
+				}
+
+				idleTimer.expires_after(std::chrono::milliseconds(adapter.keepAliveTimeout_));
+				idleTimer.async_wait([self = this->shared_from_this()](beast::error_code ec) {
+					if (ec == boost::asio::error::operation_aborted || !self->reading || !self->pending.empty()) {
+						return;
+					}
+
+					self->adapter.logAccess("HTTP keep-alive timeout " + self->remoteIp);
+					beast::error_code ignored;
+					self->socket().shutdown(tcp::socket::shutdown_both, ignored);
+					self->socket().close(ignored);
+				});
+			}
+
+			void doUpgrade() {
+				idleTimer.cancel();
+
+				auto wsSession = std::make_shared<WsSession<Stream>>(adapter, std::move(stream), remoteIp, tlsContext);
+				auto h = makeHandle(std::static_pointer_cast<SessionBase>(wsSession));
+				wsSession->doAccept(std::move(*upgradeReq), h);
+				upgradeReq.reset();
+			}
+
+			void closeIfIdle() {
+				if (closing && !reading && !writing && pending.empty()) {
+					doClose();
+				}
 			}
 
-			static ConnectionHdl makeHandle(const std::shared_ptr<SessionBase>& s) {
-				std::weak_ptr<void> w = std::static_pointer_cast<void>(s);
-				return w;
+			// Drop all pending responses and close the connection
+			void abort() {
+				closing = true;
+				for (const auto& e : pending) {
+					e->connection.reset();
+				}
+
+				pending.clear();
+				upgradeReq.reset();
+				doClose();
+			}
+
+			void doClose() {
+				idleTimer.cancel();
+				writeTimer.cancel();
+
+				if constexpr (IS_TLS) {
+					if (!reading && !writing) {
+						// Send close_notify
+						beast::get_lowest_layer(stream).expires_after(std::chrono::seconds(TLS_HANDSHAKE_TIMEOUT));
+						stream.async_shutdown([self = this->shared_from_this()](beast::error_code) {
+							beast::error_code ignored;
+							self->socket().close(ignored);
+						});
+						return;
+					}
+				}
+
+				beast::error_code ec;
+				socket().shutdown(tcp::socket::shutdown_send, ec);
 			}
 
+			static constexpr size_t MAX_PIPELINED_REQUESTS = 16;
+			static constexpr int HTTP_WRITE_TIMEOUT = 60; // seconds, renewed after each written chunk
+			static constexpr std::uint64_t SENDFILE_CHUNK_SIZE = 1024 * 1024;
+			static constexpr int TLS_HANDSHAKE_TIMEOUT = 30; // seconds
+
 			BeastServerAdapter& adapter;
-			beast::tcp_stream stream;
+
+			// Must outlive the stream
+			const contextPtr tlsContext;
+			Stream stream;
 			beast::flat_buffer buffer;
-			http::request<http::string_body> req;
-			http::status respStatus = http::status::ok;
-			std::vector<std::pair<std::string,std::string>> respHeaders;
-			std::string respBody;
-			bool deferred = false;
-			ConnectionHdl hdl;
+			boost::asio::steady_timer idleTimer;
+			boost::asio::steady_timer writeTimer;
+			const std::string remoteIp;
+
+			std::optional<http::request_parser<http::empty_body>> headerParser;
+			std::optional<http::request_parser<http::string_body>> bodyParser;
+			std::optional<http::request_parser<http::file_body>> fileParser;
+			std::shared_ptr<http::response<http::empty_body>> continueRes;
+			std::optional<http::request<http::string_body>> upgradeReq;
+
+			std::deque<HttpExchangePtr> pending;
 			std::shared_ptr<http::response<http::string_body>> respPtr;
-			std::shared_ptr<HttpSession> selfKeep;
+			std::shared_ptr<http::response<http::empty_body>> headRes;
+			std::shared_ptr<http::response<http::span_body<const char>>> bufferRes;
+
+			// File responses
+			std::shared_ptr<http::response<BeastFileRangeBody>> fileRes;
+			std::shared_ptr<http::response_serializer<BeastFileRangeBody>> fileSerializer;
+			std::uint64_t sendfileOffset = 0;
+
+			int requestCount = 0;
+			bool reading = false;
+			bool writing = false;
+			bool closing = false;
 		};
 
-		struct WsSession : public SessionBase, public std::enable_shared_from_this<WsSession> {
-			WsSession(BeastServerAdapter& owner, tcp::socket&& socket, const std::string& ip)
-				: adapter(owner), ws(std::move(socket)) {
+		struct WsSessionBase : public SessionBase {
+			virtual void sendText(const std::shared_ptr<const std::string>& text, const WsMessageInfo& info) = 0;
+			virtual void sendPing() = 0;
+			virtual void sendClose(uint16_t code, const std::string& reason) = 0;
+
+			std::string target;
+			std::string methodStr = "GET";
+			std::string subprotocol;
+		};
+
+		template<class Stream>
+		struct WsSession : public WsSessionBase, public std::enable_shared_from_this<WsSession<Stream>> {
+			WsSession(BeastServerAdapter& owner, Stream&& aStream, const std::string& ip, const contextPtr& aTlsContext)
+				: adapter(owner), tlsContext(aTlsContext), ws(std::move(aStream)), pongTimer(ws.get_executor()) {
 				remoteIp = ip;
 			}
 
+			~WsSession() override {
+				adapter.wsQueuedMessages_ -= outQueue.size();
+				adapter.wsQueuedBytes_ -= outQueueBytes;
+			}
+
 			void doAccept(http::request<http::string_body>&& req, ConnectionHdl handle) {
 				// Persist the HTTP request for the async_accept lifetime
 				upgradeReq_ = std::move(req);
@@ -276,9 +885,23 @@ namespace webserver {
 				target = std::string(upgradeReq_.target());
 				methodStr = std::string(upgradeReq_.method_string());
 				hdl = handle;
-				// Accept the websocket handshake
+				subprotocol = adapter.selectWsSubprotocol(upgradeReq_[http::field::sec_websocket_protocol]);
+				if (!subprotocol.empty()) {
+					ws.set_option(websocket::stream_base::decorator([proto = subprotocol](websocket::response_type& res) {
+						res.set(http::field::sec_websocket_protocol, proto);
+					}));
+				}
+
+				// Accept the websocket handshake (websocket stream has its own timeouts)
+				beast::get_lowest_layer(ws).expires_never();
 				ws.set_option(websocket::stream_base::timeout::suggested(beast::role_type::server));
-				ws.async_accept(upgradeReq_, beast::bind_front_handler(&WsSession::onAccept, shared_from_this()));
+				ws.set_option(adapter.wsDeflate_);
+				ws.control_callback([this](websocket::frame_type aType, beast::string_view) {
+					if (aType == websocket::frame_type::pong) {
+						onPongReceived();
+					}
+				});
+				ws.async_accept(upgradeReq_, beast::bind_front_handler(&WsSession::onAccept, this->shared_from_this()));
 			}
 
 			void onAccept(beast::error_code ec) {
@@ -294,44 +917,88 @@ namespace webserver {
 			}
 
 			void readLoop() {
-				ws.async_read(buffer, beast::bind_front_handler(&WsSession::onRead, shared_from_this()));
+				ws.async_read(buffer, beast::bind_front_handler(&WsSession::onRead, this->shared_from_this()));
 			}
 
 			void onRead(beast::error_code ec, std::size_t) {
 				if (ec) {
+					pongTimer.cancel();
 					adapter.logAccess("WS close " + target + " reason=" + ec.message());
 					if (adapter.onClose_) adapter.onClose_(hdl);
 					return;
 				}
 				if (adapter.onMessage_) {
-					auto data = beast::buffers_to_string(buffer.cdata());
+					// The flat buffer is contiguous so the message can be passed without copying
+					const auto data = buffer.cdata();
 					adapter.logAccess("WS message bytes=" + std::to_string(data.size()));
-					adapter.onMessage_(hdl, data);
+					adapter.onMessage_(hdl, std::string_view(static_cast<const char*>(data.data()), data.size()));
 				}
 				buffer.consume(buffer.size());
 				readLoop();
 			}
 
 			// Thread-safe send helpers queued on the ws executor
-			void sendText(const std::string& text) {
-				auto self = shared_from_this();
-				boost::asio::post(ws.get_executor(), [self, text] {
-					self->outQueue.push_back(text);
-					if (!self->writing) {
-						self->startWrite();
-					}
+			void sendText(const std::shared_ptr<const std::string>& text, const WsMessageInfo& info) override {
+				auto self = this->shared_from_this();
+				boost::asio::post(ws.get_executor(), [self, message = QueuedMessage{ text, info }]() mutable {
+					self->enqueue(std::move(message));
 				});
 			}
 
-			void sendPing() {
-				auto self = shared_from_this();
+			void sendPing() override {
+				auto self = this->shared_from_this();
 				boost::asio::post(ws.get_executor(), [self] {
 					self->ws.async_ping(websocket::ping_data{}, [self](beast::error_code ec){ if(ec) self->adapter.logError("WS ping error: "+ec.message()); });
+					self->startPongTimer();
+				});
+			}
+
+			void startPongTimer() {
+				if (adapter.pongTimeout_ <= 0 || awaitingPong || pongTimedOut) {
+					return;
+				}
+
+				awaitingPong = true;
+				pongTimer.expires_after(std::chrono::milliseconds(adapter.pongTimeout_));
+				pongTimer.async_wait([self = this->shared_from_this()](beast::error_code ec) {
+					if (ec) {
+						return;
+					}
+
+					self->onPongTimeout();
 				});
 			}
 
-			void sendClose(uint16_t code, const std::string& /*reason*/) {
-				auto self = shared_from_this();
+			void onPongReceived() {
+				if (!awaitingPong || pongTimedOut) {
+					return;
+				}
+
+				awaitingPong = false;
+				pongTimer.cancel();
+			}
+
+			void onPongTimeout() {
+				awaitingPong = false;
+				pongTimedOut = true;
+				adapter.logError("WS pong timeout " + target + " (" + remoteIp + ")");
+
+				// Uses the normal close path
+				if (adapter.onPongTimeout_) adapter.onPongTimeout_(hdl, std::string());
+
+				// The closing handshake won't complete if the peer is gone, drop the connection after another timeout period
+				pongTimer.expires_after(std::chrono::milliseconds(adapter.pongTimeout_));
+				pongTimer.async_wait([self = this->shared_from_this()](beast::error_code ec) {
+					if (ec) {
+						return;
+					}
+
+					beast::get_lowest_layer(self->ws).close();
+				});
+			}
+
+			void sendClose(uint16_t code, const std::string& /*reason*/) override {
+				auto self = this->shared_from_this();
 				boost::asio::post(ws.get_executor(), [self, code] {
 					websocket::close_reason cr;
 					cr.code = static_cast<websocket::close_code>(code);
@@ -339,19 +1006,114 @@ namespace webserver {
 				});
 			}
 
+			// The text may be shared with other connections (events are serialized only once)
+			struct QueuedMessage {
+				std::shared_ptr<const std::string> text;
+				WsMessageInfo info;
+			};
+
+			void enqueue(QueuedMessage&& message) {
+				if (closingSlowClient) {
+					return;
+				}
+
+				const auto policy = adapter.wsQueuePolicy_;
+				const auto supersedable = policy != WsSendQueuePolicy::DISCONNECT && !message.info.supersedeKey.empty();
+				if (supersedable) {
+					// Remove the previous message that hasn't been sent yet
+					// The new one is appended so that it won't be delivered before the messages queued after the old one
+					auto i = supersedableMessages.find(message.info.supersedeKey);
+					if (i != supersedableMessages.end()) {
+						auto superseded = i->second;
+						supersedableMessages.erase(i);
+
+						outQueueBytes -= superseded->text->size();
+						adapter.wsQueuedBytes_ -= superseded->text->size();
+						adapter.wsQueuedMessages_--;
+						outQueue.erase(superseded);
+						adapter.wsCoalescedMessages_++;
+					}
+				}
+
+				if (isQueueFull(message.text->size())) {
+					if (policy == WsSendQueuePolicy::DROP && message.info.droppable) {
+						adapter.wsDroppedMessages_++;
+						return;
+					}
+
+					closeSlowClient();
+					return;
+				}
+
+				outQueueBytes += message.text->size();
+				adapter.wsQueuedBytes_ += message.text->size();
+				adapter.wsQueuedMessages_++;
+				outQueue.push_back(std::move(message));
+				if (supersedable) {
+					supersedableMessages[outQueue.back().info.supersedeKey] = std::prev(outQueue.end());
+				}
+
+				if (!writing) {
+					startWrite();
+				}
+			}
+
+			bool isQueueFull(std::size_t aNewBytes) const noexcept {
+				if (adapter.wsQueueMaxMessages_ > 0 && outQueue.size() + 1 > adapter.wsQueueMaxMessages_) {
+					return true;
+				}
+
+				return adapter.wsQueueMaxBytes_ > 0 && outQueueBytes + aNewBytes > adapter.wsQueueMaxBytes_;
+			}
+
+			void closeSlowClient() {
+				adapter.logError("WS outgoing queue full for " + remoteIp + " (" + std::to_string(outQueue.size()) + " messages, " + std::to_string(outQueueBytes) + " bytes), disconnecting");
+				adapter.wsQueueDisconnects_++;
+				closingSlowClient = true;
+
+				// Release the memory (except for the message being written)
+				supersedableMessages.clear();
+				while (outQueue.size() > (writing ? 1 : 0)) {
+					popMessage(outQueue.back().text->size(), false);
+				}
+
+				sendClose(static_cast<uint16_t>(websocket::close_code::policy_error), "Client is too slow to receive messages");
+			}
+
+			void popMessage(std::size_t aBytes, bool aFront) {
+				outQueueBytes -= aBytes;
+				adapter.wsQueuedBytes_ -= aBytes;
+				adapter.wsQueuedMessages_--;
+				if (aFront) {
+					outQueue.pop_front();
+				} else {
+					outQueue.pop_back();
+				}
+			}
+
 			void startWrite() {
 				if (outQueue.empty()) return;
 				writing = true;
-				ws.text(true);
-				auto self = shared_from_this();
-				ws.async_write(boost::asio::buffer(outQueue.front()), [self](beast::error_code ec, std::size_t bytes) {
+
+				// The message being written can't be replaced anymore
+				const auto& key = outQueue.front().info.supersedeKey;
+				if (!key.empty()) {
+					auto i = supersedableMessages.find(key);
+					if (i != supersedableMessages.end() && i->second == outQueue.begin()) {
+						supersedableMessages.erase(i);
+					}
+				}
+
+				ws.binary(outQueue.front().info.binary);
+				auto self = this->shared_from_this();
+				ws.async_write(boost::asio::buffer(*outQueue.front().text), [self](beast::error_code ec, std::size_t bytes) {
 					if (ec) {
 						self->adapter.logError("WS write error: " + ec.message());
 						if (self->adapter.onClose_) self->adapter.onClose_(self->hdl);
 						return;
 					}
 					self->adapter.logAccess("WS sent bytes=" + std::to_string(bytes));
-					self->outQueue.pop_front();
+					self->popMessage(self->outQueue.front().text->size(), true);
 					if (!self->outQueue.empty()) {
 						self->startWrite();
 					} else {
@@ -361,13 +1123,24 @@ namespace webserver {
 			}
 
 			BeastServerAdapter& adapter;
-			websocket::stream<tcp::socket> ws;
+
+			// Must outlive the stream
+			const contextPtr tlsContext;
+			websocket::stream<Stream> ws;
 			beast::flat_buffer buffer;
 			ConnectionHdl hdl;
-			std::string target;
-			std::string methodStr = "GET";
-			std::deque<std::string> outQueue;
+			std::list<QueuedMessage> outQueue;
+			std::size_t outQueueBytes = 0;
+
+			// Queued messages that can still be replaced by a newer one, by supersede key
+			std::unordered_map<std::string, std::list<QueuedMessage>::iterator> supersedableMessages;
 			bool writing = false;
+			bool closingSlowClient = false;
+
+			// Ping/pong state
+			boost::asio::steady_timer pongTimer;
+			bool awaitingPong = false;
+			bool pongTimedOut = false;
 			http::request<http::string_body> upgradeReq_;
 		};
 
@@ -376,13 +1149,32 @@ namespace webserver {
 			auto p = hdl.lock();
 			return std::static_pointer_cast<SessionBase>(p);
 		}
-		std::shared_ptr<HttpSession> lockHttp(ConnectionHdl hdl) const {
+		std::shared_ptr<HttpExchange> lockHttp(ConnectionHdl hdl) const {
 			auto p = hdl.lock();
-			return std::dynamic_pointer_cast<HttpSession>(std::static_pointer_cast<SessionBase>(p));
+			return std::dynamic_pointer_cast<HttpExchange>(std::static_pointer_cast<SessionBase>(p));
 		}
-		std::shared_ptr<WsSession> lockWs(ConnectionHdl hdl) const {
+		std::shared_ptr<WsSessionBase> lockWs(ConnectionHdl hdl) const {
 			auto p = hdl.lock();
-			return std::dynamic_pointer_cast<WsSession>(std::static_pointer_cast<SessionBase>(p));
+			return std::dynamic_pointer_cast<WsSessionBase>(std::static_pointer_cast<SessionBase>(p));
+		}
+
+		// Returns the first subprotocol listed in the request header that is supported by us
+		std::string selectWsSubprotocol(beast::string_view aHeader) const {
+			while (!aHeader.empty()) {
+				auto pos = aHeader.find(',');
+				auto token = aHeader.substr(0, pos);
+				aHeader = pos == beast::string_view::npos ? beast::string_view() : aHeader.substr(pos + 1);
+
+				while (!token.empty() && token.front() == ' ') token.remove_prefix(1);
+				while (!token.empty() && token.back() == ' ') token.remove_suffix(1);
+
+				auto i = std::find(wsSubprotocols_.begin(), wsSubprotocols_.end(), token);
+				if (i != wsSubprotocols_.end()) {
+					return *i;
+				}
+			}
+
+			return {};
 		}
 
 		void ensureAcceptor() {
@@ -400,6 +1192,30 @@ namespace webserver {
 			if (ec) logError("Listen error: " + ec.message());
 		}
 
+		void startSession(tcp::socket&& socket, const std::string& ip) {
+			if (!tlsInitHandler_) {
+				std::make_shared<HttpSession<PlainStream>>(*this, PlainStream(std::move(socket)), ip, nullptr)->run();
+				return;
+			}
+
+			// The same context is returned for all connections until the certificate changes
+			// (required for TLS session resumption)
+			contextPtr ctx;
+			try {
+				ctx = tlsInitHandler_();
+			} catch (const std::exception& e) {
+				logError(std::string("TLS init failed: ") + e.what());
+			}
+
+			if (!ctx) {
+				beast::error_code ignored;
+				socket.close(ignored);
+				return;
+			}
+
+			std::make_shared<HttpSession<TlsStream>>(*this, TlsStream(std::move(socket), *ctx), ip, ctx)->run();
+		}
+
 		void doAccept() {
 			acceptor_->async_accept(
 				boost::asio::make_strand(*ios_),
@@ -408,8 +1224,7 @@ namespace webserver {
 					if (!ec) {
 						auto ip = socket.remote_endpoint(ec).address().to_string();
 						logAccess("ACCEPT " + ip);
-						auto httpSess = std::make_shared<HttpSession>(*this, std::move(socket), ip);
-						httpSess->run();
+						startSession(std::move(socket), ip);
 						doAccept();
 					} else {
 						logError("Accept error: " + ec.message());
@@ -424,11 +1239,37 @@ namespace webserver {
 		bool listening_ = false;
 		bool reuseAddr_ = false;
 
-		std::function<void(ConnectionHdl, const std::string&)> onMessage_;
+		int pongTimeout_ = 0;
+
+		int keepAliveTimeout_ = 0;
+		int keepAliveMaxRequests_ = 0;
+
+		std::uint64_t maxHttpBodySize_ = 1024 * 1024;
+		std::uint64_t maxHttpUploadSize_ = 1024 * 1024;
+
+		std::size_t wsQueueMaxBytes_ = 0;
+		std::size_t wsQueueMaxMessages_ = 0;
+		WsSendQueuePolicy wsQueuePolicy_ = WsSendQueuePolicy::DISCONNECT;
+
+		std::vector<std::string> wsSubprotocols_;
+
+		// Outgoing WebSocket queue statistics
+		std::atomic<std::uint64_t> wsQueuedMessages_ { 0 };
+		std::atomic<std::uint64_t> wsQueuedBytes_ { 0 };
+		std::atomic<std::uint64_t> wsCoalescedMessages_ { 0 };
+		std::atomic<std::uint64_t> wsDroppedMessages_ { 0 };
+		std::atomic<std::uint64_t> wsQueueDisconnects_ { 0 };
+
+		// Negotiated with the client during the WebSocket handshake (disabled by default)
+		websocket::permessage_deflate wsDeflate_;
+
+		std::function<void(ConnectionHdl, std::string_view)> onMessage_;
 		std::function<void(ConnectionHdl)> onHttp_;
+		std::function<std::string(ConnectionHdl)> onHttpBodyFile_;
 		std::function<void(ConnectionHdl)> onClose_;
 		std::function<void(ConnectionHdl)> onOpen_;
 		std::function<void(ConnectionHdl, const std::string&)> onPongTimeout_;
+		std::function<contextPtr()> tlsInitHandler_;
 
 		// logging state
 		mutable std::mutex logMutex_;
@@ -0,0 +1,123 @@
+/*
+* Copyright (C) 2011-2024 AirDC++ Project
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+*/
+
+#include "stdinc.h"
+
+#include <web-server/EventBus.h>
+#include <web-server/Session.h>
+#include <web-server/WebSocket.h>
+#include <web-server/WebUser.h>
+
+#include <api/base/SubscribableApiModule.h>
+
+#include <array>
+
+namespace webserver {
+	void EventBus::subscribe(const string& aEvent, SubscribableApiModule* aModule) noexcept {
+		WLock l(cs);
+		auto& eventSubscribers = subscribers[aEvent];
+		if (ranges::find(eventSubscribers, aModule) == eventSubscribers.end()) {
+			eventSubscribers.push_back(aModule);
+		}
+	}
+
+	void EventBus::unsubscribe(const string& aEvent, SubscribableApiModule* aModule) noexcept {
+		WLock l(cs);
+		auto i = subscribers.find(aEvent);
+		if (i == subscribers.end()) {
+			return;
+		}
+
+		std::erase(i->second, aModule);
+		if (i->second.empty()) {
+			subscribers.erase(i);
+		}
+	}
+
+	bool EventBus::hasSubscribers(const string& aEvent) const noexcept {
+		RLock l(cs);
+		return subscribers.contains(aEvent);
+	}
+
+	size_t EventBus::publish(const string& aEvent, const DataCallback& aDataCallback) noexcept {
+		// Collect the sockets while holding the lock (modules unsubscribe before they are destroyed)
+		// Serializing and sending are done without the lock
+		vector<WebSocketPtr> sockets;
+
+		{
+			RLock l(cs);
+			auto i = subscribers.find(aEvent);
+			if (i == subscribers.end()) {
+				return 0;
+			}
+
+			for (const auto& module: i->second) {
+				// Permissions of the user may have changed after subscribing
+				if (!module->getSession()->getUser()->hasPermission(module->getSubscriptionAccess())) {
+					continue;
+				}
+
+				auto socket = module->getSocket();
+				if (socket) {
+					sockets.push_back(std::move(socket));
+				}
+			}
+		}
+
+		if (sockets.empty()) {
+			return 0;
+		}
+
+		json event = {
+			{ "event", aEvent },
+		};
+
+		try {
+			event["data"] = aDataCallback();
+		} catch (const json::exception& e) {
+			dcdebug("EventBus: failed to serialize the event %s (%s)\n", aEvent.c_str(), e.what());
+			return 0;
+		}
+
+		const auto messageInfo = SubscribableApiModule::getEventMessageInfo(event);
+
+		// Encoded when the first socket using the format is found
+		std::array<std::shared_ptr<const string>, static_cast<size_t>(MessageFormat::FORMAT_LAST)> encodedData;
+
+		size_t sent = 0;
+		for (const auto& socket: sockets) {
+			const auto format = socket->getMessageFormat();
+			auto& data = encodedData[static_cast<size_t>(format)];
+			if (!data) {
+				try {
+					data = std::make_shared<const string>(WebSocket::encode(event, format));
+				} catch (const json::exception& e) {
+					dcdebug("EventBus: failed to serialize the event %s (%s)\n", aEvent.c_str(), e.what());
+					return sent;
+				}
+			}
+
+			socket->sendShared(data, messageInfo);
+			sent++;
+		}
+
+		published++;
+		deliveries += sent;
+		return sent;
+	}
+}
@@ -0,0 +1,96 @@
+/*
+* Copyright (C) 2011-2024 AirDC++ Project
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+*/
+
+#ifndef DCPLUSPLUS_WEBSERVER_EVENTBUS_H
+#define DCPLUSPLUS_WEBSERVER_EVENTBUS_H
+
+#include "forward.h"
+
+#include <airdcpp/core/header/typedefs.h>
+#include <airdcpp/core/thread/CriticalSection.h>
+
+#include <atomic>
+#include <typeindex>
+#include <unordered_map>
+
+namespace webserver {
+	class SubscribableApiModule;
+
+	// Fan-out for events that have identical content for all sessions
+	// The event is serialized once and the same buffer is queued for each subscribed socket
+	//
+	// Publishers are shared by all sessions so that there is a single core listener for each event type
+	// (see getPublisher), the subscriber modules don't handle the events themselves
+	class EventBus {
+	public:
+		using DataCallback = std::function<json ()>;
+
+		struct Stats {
+			uint64_t published = 0;
+			uint64_t deliveries = 0;
+		};
+
+		EventBus() = default;
+
+		void subscribe(const string& aEvent, SubscribableApiModule* aModule) noexcept;
+		void unsubscribe(const string& aEvent, SubscribableApiModule* aModule) noexcept;
+
+		bool hasSubscribers(const string& aEvent) const noexcept;
+
+		// Serializes the event once and sends it to all subscribers with access to the event
+		// The callback is called only if there are subscribers
+		// Returns the number of sockets that the event was sent to
+		size_t publish(const string& aEvent, const DataCallback& aDataCallback) noexcept;
+
+		// Returns the shared publisher instance (T is constructed with the bus as argument)
+		// The publisher is destroyed when the last module using it has been removed
+		template<class T>
+		std::shared_ptr<T> getPublisher() noexcept {
+			Lock l(publisherCS);
+			auto& publisher = publishers[std::type_index(typeid(T))];
+
+			auto ret = std::static_pointer_cast<T>(publisher.lock());
+			if (!ret) {
+				ret = std::make_shared<T>(*this);
+				publisher = ret;
+			}
+
+			return ret;
+		}
+
+		Stats getStats() const noexcept {
+			return { published, deliveries };
+		}
+
+		EventBus(EventBus&) = delete;
+		EventBus& operator=(EventBus&) = delete;
+	private:
+		using SubscriberList = std::vector<SubscribableApiModule*>;
+
+		mutable SharedMutex cs;
+		std::unordered_map<string, SubscriberList> subscribers;
+
+		CriticalSection publisherCS;
+		std::unordered_map<std::type_index, std::weak_ptr<void>> publishers;
+
+		std::atomic<uint64_t> published { 0 };
+		std::atomic<uint64_t> deliveries { 0 };
+	};
+}
+
+#endif
@@ -21,6 +21,7 @@
 #include <web-server/FileServer.h>
 #include <web-server/HttpRequest.h>
 #include <web-server/HttpUtil.h>
+#include <web-server/IServerEndpoint.h>
 #include <web-server/WebServerManager.h>
 #include <web-server/WebUserManager.h>
 
@@ -41,6 +42,10 @@
 
 #include <sstream>
 
+#ifndef _WIN32
+#include <sys/stat.h>
+#endif
+
 namespace webserver {
 	using namespace dcpp;
 
@@ -60,6 +65,7 @@ namespace webserver {
 
 	void FileServer::setResourcePath(const string& aPath) noexcept {
 		resourcePath = PathUtil::validateDirectoryPath(aPath);
+		assetCache.clear();
 	}
 
 	string FileServer::getExtension(const string& aResource) noexcept {
@@ -84,15 +90,12 @@ namespace webserver {
 		if (!extension.empty()) {
 			dcassert(extension[0] != '.');
 
-			// We have compressed versions only for JS files
-			if (extension == "js" && aRequest.getHeader("Accept-Encoding").find("gzip") != string::npos) {
-				request += ".gz";
-				headers_.emplace_back("Content-Encoding", "gzip");
-			}
-
 			if (extension != "html" && aResource != "/sw.js") {
 				// File versioning is done with hashes in filenames (except for the index file and service worker)
 				HttpUtil::addCacheControlHeader(headers_, 365);
+			} else {
+				// Always revalidate (using the ETag)
+				headers_.emplace_back("Cache-Control", "no-cache");
 			}
 		} else {
 			// Forward all requests for non-static files to index
@@ -108,8 +111,8 @@ namespace webserver {
 
 			request = "index.html";
 
-			// The main chunk name may change and it's stored in the HTML file
-			HttpUtil::addCacheControlHeader(headers_, 0);
+			// The main chunk name may change and it's stored in the HTML file (always revalidate using the ETag)
+			headers_.emplace_back("Cache-Control", "no-cache");
 		}
 
 		// Avoid double separators because of assertions
@@ -140,7 +143,7 @@ namespace webserver {
 		throw RequestException(http::status::not_found, "No viewable file matching the TTH " + aTTH.toBase32() + " was found");
 	}
 
-	string FileServer::parseViewFilePath(const string& aResource, StringPairList& headers_, const SessionPtr& aSession) const {
+	string FileServer::parseViewFilePath(const string& aResource, StringPairList& headers_, string& etag_, const SessionPtr& aSession) const {
 		string protocolTmp, tthStr, portTmp, pathTmp, query, fragmentTmp;
 		LinkUtil::decodeUrl(aResource, protocolTmp, tthStr, portTmp, pathTmp, query, fragmentTmp);
 
@@ -159,6 +162,9 @@ namespace webserver {
 		auto tth = Deserializer::parseTTH(tthStr);
 		auto path = getPath(tth);
 
+		// The content is identified by the TTH
+		etag_ = "\"" + tth.toBase32() + "\"";
+
 		HttpUtil::addCacheControlHeader(headers_, 1); // One day (files are identified by their TTH so the content won't change)
 
 		return path;
@@ -170,24 +176,30 @@ namespace webserver {
 		const auto& requestPath = aRequest.path;
 		if (requestPath == "/temp") {
 			if (!aSession || !aSession->getUser()->hasPermission(Access::FILESYSTEM_EDIT)) {
+				if (!aRequest.bodyFile.empty()) {
+					File::deleteFile(aRequest.bodyFile);
+				}
+
 				output_ = "Not authorized";
 				return http::status::unauthorized;
 			}
 
-			const auto nameHeader = aRequest.getHeader("X-File-Name");
-			auto fileName = Util::toString(ValueGenerator::rand());
-			if (!nameHeader.empty()) {
-				fileName += "_" + PathUtil::validateFileName(nameHeader);
-			}
-
-			const auto filePath = AppUtil::getPath(AppUtil::PATH_TEMP) + fileName;
-
-			try {
-				File file(filePath, File::WRITE, File::TRUNCATE | File::CREATE, File::BUFFER_SEQUENTIAL);
-				file.write(aRequest.body);
-			} catch (const FileException& e) {
-				output_ = "Failed to write the file: " + e.getError();
-				return http::status::internal_server_error;
+			string fileName, filePath;
+			if (!aRequest.bodyFile.empty()) {
+				// Written on disk by the endpoint
+				filePath = aRequest.bodyFile;
+				fileName = PathUtil::getFileName(filePath);
+			} else {
+				fileName = createTempFileName(aRequest.getHeader("X-File-Name"));
+				filePath = AppUtil::getPath(AppUtil::PATH_TEMP) + fileName;
+
+				try {
+					File file(filePath, File::WRITE, File::TRUNCATE | File::CREATE, File::BUFFER_SEQUENTIAL);
+					file.write(aRequest.body);
+				} catch (const FileException& e) {
+					output_ = "Failed to write the file: " + e.getError();
+					return http::status::internal_server_error;
+				}
 			}
 
 			{
@@ -203,6 +215,19 @@ namespace webserver {
 		return http::status::not_found;
 	}
 
+	string FileServer::createTempFileName(const string& aFileNameHeader) noexcept {
+		auto fileName = Util::toString(ValueGenerator::rand());
+		if (!aFileNameHeader.empty()) {
+			fileName += "_" + PathUtil::validateFileName(aFileNameHeader);
+		}
+
+		return fileName;
+	}
+
+	string FileServer::createTempFilePath(const string& aFileNameHeader) const noexcept {
+		return AppUtil::getPath(AppUtil::PATH_TEMP) + createTempFileName(aFileNameHeader);
+	}
+
 	string FileServer::getTempFilePath(const string& fileId) const noexcept {
 		RLock l(cs);
 		auto i = tempFiles.find(fileId);
@@ -210,10 +235,10 @@ namespace webserver {
 	}
 
 	http::status FileServer::handleRequest(const HttpRequest& aRequest,
-		string& output_, StringPairList& headers_, const FileDeferredHandler& aDeferF) {
+		string& output_, StringPairList& headers_, optional<HttpFileBody>& fileBody_, const FileDeferredHandler& aDeferF) {
 
-		if (aRequest.method == "GET") {
-			return handleGetRequest(aRequest, output_, headers_, aRequest.session, aDeferF);
+		if (aRequest.method == "GET" || aRequest.method == "HEAD") {
+			return handleGetRequest(aRequest, output_, headers_, fileBody_, aRequest.session, aDeferF);
 		} else if (aRequest.method == "POST") {
 			return handlePostRequest(aRequest, output_, headers_, aRequest.session);
 		}
@@ -223,7 +248,7 @@ namespace webserver {
 	}
 
 	http::status FileServer::handleGetRequest(const HttpRequest& aRequest,
-		string& output_, StringPairList& headers_, const SessionPtr& aSession, const FileDeferredHandler& aDeferF) {
+		string& output_, StringPairList& headers_, optional<HttpFileBody>& fileBody_, const SessionPtr& aSession, const FileDeferredHandler& aDeferF) {
 
 		const auto& requestUrl = aRequest.path;
 		dcdebug("Requesting file %s\n", requestUrl.c_str());
@@ -239,11 +264,11 @@ namespace webserver {
 		}
 
 		// File request
-		string filePath;
+		string filePath, etag;
 		auto isViewFile = requestUrl.length() >= 6 && requestUrl.compare(0, 6, "/view/") == 0;
 		try {
 			if (isViewFile) {
-				filePath = parseViewFilePath(requestUrl.substr(6), headers_, aSession);
+				filePath = parseViewFilePath(requestUrl.substr(6), headers_, etag, aSession);
 			} else if (requestUrl.length() >= 6 && requestUrl.compare(0, 6, "/proxy") == 0) {
 				if (!aSession) {
 					throw RequestException(http::status::unauthorized, "Not authorized");
@@ -252,22 +277,66 @@ namespace webserver {
 				return handleProxyDownload(requestUrl, output_, aDeferF);
 			} else {
 				filePath = parseResourcePath(requestUrl, aRequest, headers_);
+				if (auto asset = assetCache.getAsset(filePath)) {
+					return handleAssetRequest(aRequest, *asset, headers_, fileBody_);
+				}
+
+				// Not cacheable, the UI build has compressed versions of JS files
+				if (getExtension(filePath) == "js") {
+					if (aRequest.getHeader("Accept-Encoding").find("gzip") != string::npos) {
+						filePath += ".gz";
+						headers_.emplace_back("Content-Encoding", "gzip");
+					}
+
+					headers_.emplace_back("Vary", "Accept-Encoding");
+				}
 			}
 		} catch (const RequestException& e) {
 			output_ = e.what();
 			return e.getCode();
 		}
 
-		auto fileSize = File::getSize(filePath);
+		int64_t fileSize = -1;
+		time_t lastModified = 0;
+		uint64_t fileId = 0;
+		if (getFileInfo(filePath, fileSize, lastModified, fileId)) {
+			// Validators for conditional requests (answered without opening the file)
+			if (!isViewFile) {
+				etag = "\"" + Util::toString(lastModified) + "-" + Util::toString(fileSize) + "-" + Util::toString(fileId) + "\"";
+				headers_.emplace_back("Last-Modified", HttpUtil::formatHttpDate(lastModified));
+			}
+
+			headers_.emplace_back("ETag", etag);
+			if (isNotModified(aRequest, etag, isViewFile ? 0 : lastModified)) {
+				return http::status::not_modified;
+			}
+		}
+
 		int64_t startPos = 0, endPos = fileSize - 1;
 
 		auto partialContent = HttpUtil::parsePartialRange(aRequest.getHeader("Range"), startPos, endPos);
+		const auto contentLength = std::max<int64_t>(endPos - startPos + 1, 0);
+		const auto ext = PathUtil::getFileExt(filePath);
 
-		// Read file
 		try {
-			File f(filePath, File::READ, File::OPEN);
-			f.setPos(startPos);
-			output_ = f.read(static_cast<size_t>(endPos) + 1);
+			if (ext == ".nfo") {
+				File f(filePath, File::READ, File::OPEN);
+				// Encoding conversion needs the content in memory (NFO files are small)
+				// This is done for HEAD requests as well so that the content length matches the converted body
+				f.setPos(startPos);
+				output_ = f.read(static_cast<size_t>(contentLength));
+			} else if (aRequest.method == "HEAD") {
+				if (fileSize < 0) {
+					throw FileException("File not found");
+				}
+
+				// Only the headers are sent (the endpoint won't open the file)
+				fileBody_ = HttpFileBody{ filePath, startPos, contentLength };
+			} else {
+				// The content is streamed by the endpoint
+				File f(filePath, File::READ, File::OPEN);
+				fileBody_ = HttpFileBody{ filePath, startPos, contentLength };
+			}
 		} catch (const FileException& e) {
 			dcdebug("Failed to serve the file %s: %s\n", filePath.c_str(), e.getError().c_str());
 
@@ -280,19 +349,16 @@ namespace webserver {
 			return http::status::internal_server_error;
 		}
 
-		{
-			const auto ext = PathUtil::getFileExt(filePath);
-			if (ext == ".nfo") {
-				string encoding;
+		if (!output_.empty() && ext == ".nfo") {
+			string encoding;
 
-				// Platform-independent encoding conversion function could be added if there is more use for it
+			// Platform-independent encoding conversion function could be added if there is more use for it
 #ifdef _WIN32
-				encoding = "CP.437";
+			encoding = "CP.437";
 #else
-				encoding = "cp437";
+			encoding = "cp437";
 #endif
-				output_ = Text::toUtf8(output_, encoding);
-			}
+			output_ = Text::toUtf8(output_, encoding);
 		}
 
 		{
@@ -313,6 +379,83 @@ namespace webserver {
 		return http::status::ok;
 	}
 
+	http::status FileServer::handleAssetRequest(const HttpRequest& aRequest, const AssetCache::Asset& aAsset, StringPairList& headers_, optional<HttpFileBody>& fileBody_) noexcept {
+		const auto encoding = AssetCache::selectEncoding(aAsset, aRequest.getHeader("Accept-Encoding"));
+		const auto& content = aAsset.content[encoding];
+		const auto& etag = aAsset.etags[encoding];
+
+		if (encoding != AssetCache::ENCODING_IDENTITY) {
+			headers_.emplace_back("Content-Encoding", AssetCache::getEncodingName(encoding));
+		}
+
+		if (aAsset.hasCompressedVariants()) {
+			headers_.emplace_back("Vary", "Accept-Encoding");
+		}
+
+		headers_.emplace_back("ETag", etag);
+		headers_.emplace_back("Last-Modified", aAsset.lastModified);
+		if (isNotModified(aRequest, etag, aAsset.modified)) {
+			return http::status::not_modified;
+		}
+
+		if (aAsset.mimeType) {
+			headers_.emplace_back("Content-Type", aAsset.mimeType);
+		}
+
+		const auto contentSize = static_cast<int64_t>(content->size());
+		int64_t startPos = 0, endPos = contentSize - 1;
+		auto partialContent = HttpUtil::parsePartialRange(aRequest.getHeader("Range"), startPos, endPos);
+
+		// The endpoint writes the content directly from the cache
+		fileBody_ = HttpFileBody{ aAsset.path, startPos, std::max<int64_t>(endPos - startPos + 1, 0), content };
+
+		if (partialContent) {
+			headers_.emplace_back("Content-Range", HttpUtil::formatPartialRange(startPos, endPos, contentSize));
+			headers_.emplace_back("Accept-Ranges", "bytes");
+			return http::status::partial_content;
+		}
+
+		return http::status::ok;
+	}
+
+	bool FileServer::getFileInfo(const string& aPath, int64_t& size_, time_t& modified_, uint64_t& fileId_) noexcept {
+#ifdef _WIN32
+		size_ = File::getSize(aPath);
+		if (size_ < 0) {
+			return false;
+		}
+
+		modified_ = File::getLastModified(aPath);
+		fileId_ = 0;
+#else
+		struct stat st;
+		if (::stat(aPath.c_str(), &st) != 0 || !S_ISREG(st.st_mode)) {
+			return false;
+		}
+
+		size_ = static_cast<int64_t>(st.st_size);
+		modified_ = st.st_mtime;
+		fileId_ = static_cast<uint64_t>(st.st_ino);
+#endif
+		return true;
+	}
+
+	bool FileServer::isNotModified(const HttpRequest& aRequest, const string& aETag, time_t aLastModified) noexcept {
+		// If-Modified-Since is ignored when If-None-Match is present
+		const auto ifNoneMatch = aRequest.getHeader("If-None-Match");
+		if (!ifNoneMatch.empty()) {
+			return HttpUtil::matchETag(ifNoneMatch, aETag);
+		}
+
+		const auto ifModifiedSince = aRequest.getHeader("If-Modified-Since");
+		if (!ifModifiedSince.empty() && aLastModified > 0) {
+			const auto since = HttpUtil::parseHttpDate(ifModifiedSince);
+			return since > 0 && aLastModified <= since;
+		}
+
+		return false;
+	}
+
 	http::status FileServer::handleProxyDownload(const string& aRequestUrl, string& output_, const FileDeferredHandler& aDeferF) noexcept {
 		string protocol, host, port, path, query, fragment;
 		LinkUtil::decodeUrl(aRequestUrl, protocol, host, port, path, query, fragment);
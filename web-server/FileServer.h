@@ -21,12 +21,15 @@
 
 #include "forward.h"
 
+#include <web-server/AssetCache.h>
+
 #include <airdcpp/core/header/typedefs.h>
 #include <airdcpp/core/thread/CriticalSection.h>
 
 
 namespace webserver {
 	struct HttpRequest;
+	struct HttpFileBody;
 	class FileServer {
 	public:
 		FileServer();
@@ -37,17 +40,29 @@ namespace webserver {
 		// Get location of the file server root directory (Web UI files)
 		const string& getResourcePath() const noexcept;
 
+		// Large files are returned in fileBody_ so that they can be streamed by the endpoint
 		http::status handleRequest(const HttpRequest& aRequest, 
-			std::string& output_, StringPairList& headers_, const FileDeferredHandler& aDeferF);
+			std::string& output_, StringPairList& headers_, optional<HttpFileBody>& fileBody_, const FileDeferredHandler& aDeferF);
 
 		string getTempFilePath(const string& fileId) const noexcept;
+
+		// Get a new path for an uploaded temp file
+		string createTempFilePath(const string& aFileNameHeader) const noexcept;
 		void stop() noexcept;
 
+		AssetCache::Stats getAssetCacheStats() const noexcept {
+			return assetCache.getStats();
+		}
+
+		// Reads the file metadata without opening the file (fileId_ is the inode number if available)
+		// Returns false if the file doesn't exist
+		static bool getFileInfo(const string& aPath, int64_t& size_, time_t& modified_, uint64_t& fileId_) noexcept;
+
 		FileServer(FileServer&) = delete;
 		FileServer& operator=(FileServer&) = delete;
 	private:
 		http::status handleGetRequest(const HttpRequest& aRequest,
-			std::string& output_, StringPairList& headers_, const SessionPtr& aSession, const FileDeferredHandler& aDeferF);
+			std::string& output_, StringPairList& headers_, optional<HttpFileBody>& fileBody_, const SessionPtr& aSession, const FileDeferredHandler& aDeferF);
 
 		http::status handleProxyDownload(const string& aUrl, string& output_, const FileDeferredHandler& aDeferF) noexcept;
 		void onProxyDownloadCompleted(int64_t aDownloadId, const HTTPFileCompletionF& aCompletionF) noexcept;
@@ -58,11 +73,21 @@ namespace webserver {
 		string resourcePath;
 
 		string parseResourcePath(const string& aResource, const HttpRequest& aRequest, StringPairList& headers_) const;
-		string parseViewFilePath(const string& aResource, StringPairList& headers_, const SessionPtr& aSession) const;
+		string parseViewFilePath(const string& aResource, StringPairList& headers_, string& etag_, const SessionPtr& aSession) const;
 		string getPath(const TTHValue& aTTH) const;
 
 		static string getExtension(const string& aResource) noexcept;
 
+		// Serves a Web UI resource from the asset cache
+		static http::status handleAssetRequest(const HttpRequest& aRequest, const AssetCache::Asset& aAsset, StringPairList& headers_, optional<HttpFileBody>& fileBody_) noexcept;
+
+		// Whether the client has the current version of the file (If-None-Match/If-Modified-Since)
+		static bool isNotModified(const HttpRequest& aRequest, const string& aETag, time_t aLastModified) noexcept;
+
+		static string createTempFileName(const string& aFileNameHeader) noexcept;
+
+		AssetCache assetCache;
+
 		mutable SharedMutex cs;
 		StringMap tempFiles;
 
@@ -17,8 +17,10 @@
 */
 
 #include "stdinc.h"
+#include <web-server/version.h>
 
 #include <web-server/HttpManager.h>
+#include <web-server/ApiMetrics.h>
 #include <web-server/ApiRouter.h>
 #include <web-server/HttpUtil.h>
 
@@ -26,6 +28,8 @@
 #include <web-server/HttpRequest.h>
 #include <web-server/Session.h>
 
+#include <airdcpp/core/io/File.h>
+
 
 namespace webserver {
 
@@ -41,7 +45,7 @@ namespace webserver {
 		fileServer.stop();
 	}
 
-	http::status HttpManager::handleApiRequest(const HttpRequest& aRequest, json& output_, json& error_, const ApiDeferredHandler& aDeferredHandler) noexcept
+	http::status HttpManager::handleApiRequest(const HttpRequest& aRequest, json& output_, json& error_, string& rawOutput_, const ApiDeferredHandler& aDeferredHandler) noexcept
 	{
 		dcdebug("Received HTTP request: %s\n", aRequest.body.c_str());
 
@@ -57,6 +61,8 @@ namespace webserver {
 
 		try {
 			ApiRequest apiRequest(aRequest.path, aRequest.method, std::move(bodyJson), aRequest.session, aDeferredHandler, output_, error_);
+			apiRequest.setRawResponseOutput(&rawOutput_);
+
 			RouterRequest routerRequest{ apiRequest, aRequest.secure, nullptr, aRequest.ip };
 			const auto status = ApiRouter::handleRequest(routerRequest);
 			return status;
@@ -103,10 +109,27 @@ namespace webserver {
 	}
 
 	void HttpManager::handleHttpApiRequest(const HttpRequest& aRequest, IServerEndpoint& ep, ConnectionHdl hdl) {
-		wsm->onData(aRequest.path + ": " + aRequest.body, TransportType::TYPE_HTTP_API, Direction::INCOMING, aRequest.ip);
+		wsm->getMetrics().onData(TransportType::TYPE_HTTP_API, Direction::INCOMING, aRequest.body.size());
+
+		// The response is logged together with the request
+		const auto logData = wsm->isDataLogged();
+		if (logData) {
+			wsm->onData(aRequest.path + ": " + aRequest.body, TransportType::TYPE_HTTP_API, Direction::INCOMING, aRequest.ip);
+		}
 
 		// Don't capture aRequest in here (it can't be used for async actions)
-		auto responseF = [this, &ep, hdl, ip = aRequest.ip](http::status aStatus, const json& aResponseJsonData, const json& aResponseErrorJson) {
+		auto sendResponseF = [this, &ep, hdl, ip = aRequest.ip, logData](http::status aStatus, const string& aData) {
+			wsm->getMetrics().onData(TransportType::TYPE_HTTP_API, Direction::OUTGOING, aData.size());
+			if (logData) {
+				wsm->onData(ep.getResource(hdl) + " (" + std::string(http::obsolete_reason(aStatus)) + "): " + aData, TransportType::TYPE_HTTP_API, Direction::OUTGOING, ip);
+			}
+
+			if (setHttpResponse(ep, hdl, aStatus, aData)) {
+				ep.httpAppendHeader(hdl, "Content-Type", "application/json");
+			}
+		};
+
+		auto responseF = [&ep, hdl, sendResponseF](http::status aStatus, const json& aResponseJsonData, const json& aResponseErrorJson) {
 			string data;
 			const auto& responseJson = !aResponseErrorJson.is_null() ? aResponseErrorJson : aResponseJsonData;
 			if (!responseJson.is_null()) {
@@ -120,11 +143,7 @@ namespace webserver {
 				}
 			}
 
-			wsm->onData(ep.getResource(hdl) + " (" + std::string(http::obsolete_reason(aStatus)) + "): " + data, TransportType::TYPE_HTTP_API, Direction::OUTGOING, ip);
-
-			if (setHttpResponse(ep, hdl, aStatus, data)) {
-				ep.httpAppendHeader(hdl, "Content-Type", "application/json");
-			}
+			sendResponseF(aStatus, data);
 		};
 
 		bool isDeferred = false;
@@ -139,39 +158,88 @@ namespace webserver {
 		};
 
 		json output, apiError;
+		string rawOutput;
 		auto status = handleApiRequest(
 			aRequest,
 			output,
 			apiError,
+			rawOutput,
 			deferredF
 		);
 
-		if (!isDeferred) {
+		if (isDeferred) {
+			return;
+		}
+
+		if (!rawOutput.empty() && HttpUtil::isStatusOk(status)) {
+			sendResponseF(status, rawOutput);
+		} else {
 			responseF(status, output, apiError);
 		}
 	}
 
+	bool HttpManager::isPrometheusRequest(const HttpRequest& aRequest) noexcept {
+		if (aRequest.method != "GET" || aRequest.path != "/api/v" + Util::toString(API_VERSION) + "/system/metrics") {
+			return false;
+		}
+
+		// Other clients will get the JSON version from the API
+		const auto accept = aRequest.getHeader("Accept");
+		return accept.find("text/plain") != string::npos || accept.find("application/openmetrics-text") != string::npos;
+	}
+
+	void HttpManager::handleHttpMetricsRequest(const HttpRequest& aRequest, IServerEndpoint& ep, ConnectionHdl hdl) {
+		if (!aRequest.session) {
+			setHttpResponse(ep, hdl, http::status::unauthorized, "Not authorized");
+			return;
+		}
+
+		if (!aRequest.session->getUser()->hasPermission(Access::ADMIN)) {
+			setHttpResponse(ep, hdl, http::status::forbidden, "The permission " + WebUser::accessToString(Access::ADMIN) + " is required for accessing this method");
+			return;
+		}
+
+		const auto output = wsm->getMetrics().toPrometheus(wsm->getWsSendQueueStats());
+		wsm->getMetrics().onData(TransportType::TYPE_HTTP_API, Direction::OUTGOING, output.size());
+		if (setHttpResponse(ep, hdl, http::status::ok, output)) {
+			ep.httpAppendHeader(hdl, "Content-Type", "text/plain; version=0.0.4; charset=utf-8");
+		}
+	}
+
 	void HttpManager::handleHttpFileRequest(const HttpRequest& aRequest, IServerEndpoint& ep, ConnectionHdl hdl) {
-		wsm->onData(aRequest.method + " " + aRequest.path, TransportType::TYPE_HTTP_FILE, Direction::INCOMING, aRequest.ip);
+		// The response is logged together with the request
+		const auto logData = wsm->isDataLogged();
+		if (logData) {
+			wsm->onData(aRequest.method + " " + aRequest.path, TransportType::TYPE_HTTP_FILE, Direction::INCOMING, aRequest.ip);
+		}
 
 		StringPairList headers;
 		std::string output;
+		optional<HttpFileBody> fileBody;
 
 		// Don't capture aRequest in here (it can't be used for async actions)
-		auto responseF = [this, &ep, hdl, ip = aRequest.ip](http::status aStatus, const string& aOutput, const StringPairList& aHeaders = StringPairList()) {
-			wsm->onData(
-				"GET " + ep.getResource(hdl) + ": " + std::string(http::obsolete_reason(aStatus)) + " (" + Util::formatBytes(aOutput.length()) + ")",
-				TransportType::TYPE_HTTP_FILE,
-				Direction::OUTGOING,
-				ip
-			);
+		auto responseF = [this, &ep, hdl, ip = aRequest.ip, logData](http::status aStatus, const string& aOutput, const StringPairList& aHeaders = StringPairList(), const HttpFileBody* aFileBody = nullptr) {
+			const auto bodySize = aFileBody ? aFileBody->length : static_cast<int64_t>(aOutput.length());
+			wsm->getMetrics().onData(TransportType::TYPE_HTTP_FILE, Direction::OUTGOING, static_cast<size_t>(bodySize));
+			if (logData) {
+				wsm->onData(
+					"GET " + ep.getResource(hdl) + ": " + std::string(http::obsolete_reason(aStatus)) + " (" + Util::formatBytes(bodySize) + ")",
+					TransportType::TYPE_HTTP_FILE,
+					Direction::OUTGOING,
+					ip
+				);
+			}
 
 			auto responseOk = setHttpResponse(ep, hdl, aStatus, aOutput);
-			if (responseOk && HttpUtil::isStatusOk(aStatus)) {
-				// Don't set any incomplete/invalid headers in case of errors...
+			if (responseOk && (HttpUtil::isStatusOk(aStatus) || aStatus == http::status::not_modified)) {
+				// Don't set any incomplete/invalid headers in case of errors (validators are needed for 304 responses)...
 				for (const auto& [name, value] : aHeaders) {
 					ep.httpAppendHeader(hdl, name, value);
 				}
+
+				if (aFileBody) {
+					ep.httpSetFileBody(hdl, *aFileBody);
+				}
 			}
 
 		};
@@ -187,12 +255,34 @@ namespace webserver {
 			};
 		};
 
-		auto status = fileServer.handleRequest(aRequest, output, headers, deferredF);
+		auto status = fileServer.handleRequest(aRequest, output, headers, fileBody, deferredF);
 		if (!isDeferred) {
-			responseF(status, output, headers);
+			responseF(status, output, headers, fileBody ? &(*fileBody) : nullptr);
 		}
 	}
 
+	string HttpManager::handleHttpBodyFile(IServerEndpoint& ep, ConnectionHdl hdl) noexcept {
+		if (ep.getMethod(hdl) != "POST" || ep.getResource(hdl) != "/temp") {
+			return Util::emptyString;
+		}
+
+		// Write files on disk only for uploads with an existing session
+		// (other requests will be rejected by the file server after the body has been read)
+		// Passwords must not be checked in here: the response to a large upload would reveal whether the credentials
+		// were valid without going through the auth flood protection (Basic auth uploads are always read in memory)
+		auto authToken = HttpUtil::parseAuthToken(ep.getHeader(hdl, "Authorization"), ep.getHeader(hdl, "X-Authorization"));
+		if (authToken.empty()) {
+			return Util::emptyString;
+		}
+
+		auto session = wsm->getUserManager().getExistingHttpSession(authToken);
+		if (!session || !session->getUser()->hasPermission(Access::FILESYSTEM_EDIT)) {
+			return Util::emptyString;
+		}
+
+		return fileServer.createTempFilePath(ep.getHeader(hdl, "X-File-Name"));
+	}
+
 	void HttpManager::handleHttpRequest(IServerEndpoint& ep, bool aIsSecure, ConnectionHdl hdl) {
 		// Blocking HTTP Handler
 		auto ip = ep.getRemoteIp(hdl);
@@ -202,12 +292,20 @@ namespace webserver {
 		// so session isn't required at this point
 		SessionPtr session = nullptr;
 		if (!getOptionalHttpSession(ep, hdl, ip, session)) {
+			// The session may have expired during the upload
+			auto bodyFile = ep.getBodyFilePath(hdl);
+			if (!bodyFile.empty()) {
+				File::deleteFile(bodyFile);
+			}
+
 			return;
 		}
 
 		HttpRequest request{ session, ip, ep.getResource(hdl), ep.getMethod(hdl), ep.getBody(hdl),
-			[&ep, hdl](const std::string& name) { return ep.getHeader(hdl, name); }, aIsSecure };
-		if (request.path.length() >= 4 && request.path.compare(0, 4, "/api") == 0) {
+			[&ep, hdl](const std::string& name) { return ep.getHeader(hdl, name); }, aIsSecure, ep.getBodyFilePath(hdl) };
+		if (isPrometheusRequest(request)) {
+			handleHttpMetricsRequest(request, ep, hdl);
+		} else if (request.path.length() >= 4 && request.path.compare(0, 4, "/api") == 0) {
 			handleHttpApiRequest(request, ep, hdl);
 		} else {
 			handleHttpFileRequest(request, ep, hdl);
@@ -48,15 +48,18 @@ namespace webserver {
 
 		void setEndpointHandlers(IServerEndpoint& aEndpoint, bool aIsSecure) {
 			aEndpoint.setHttpHandler(std::bind_front(&HttpManager::handleHttpRequest, this, std::ref(aEndpoint), aIsSecure));
+			aEndpoint.setHttpBodyFileHandler(std::bind_front(&HttpManager::handleHttpBodyFile, this, std::ref(aEndpoint)));
 		}
 
 		void start(const string& aWebResourcePath) noexcept;
 		void stop() noexcept;
 
 		static constexpr int64_t MAX_HTTP_BODY_SIZE = 16LL * 1024 * 1024; // 16 MiB default
+		static constexpr int64_t MAX_HTTP_UPLOAD_SIZE = 4LL * 1024 * 1024 * 1024; // 4 GiB (files uploaded to /temp)
 	private:
+		// Responses that were serialized by the handler are stored in rawOutput_
 		static api_return handleApiRequest(const HttpRequest& aRequest,
-			json& output_, json& error_, const ApiDeferredHandler& aDeferredHandler) noexcept;
+			json& output_, json& error_, string& rawOutput_, const ApiDeferredHandler& aDeferredHandler) noexcept;
 
 		// Returns false in case of invalid token format
 		bool getOptionalHttpSession(IServerEndpoint& ep, ConnectionHdl hdl, const string& aIp, SessionPtr& session_);
@@ -66,8 +69,15 @@ namespace webserver {
 		void handleHttpApiRequest(const HttpRequest& aRequest, IServerEndpoint& ep, ConnectionHdl hdl);
 		void handleHttpFileRequest(const HttpRequest& aRequest, IServerEndpoint& ep, ConnectionHdl hdl);
 
+		// Metrics in Prometheus text format (scrapers request it with the Accept header)
+		static bool isPrometheusRequest(const HttpRequest& aRequest) noexcept;
+		void handleHttpMetricsRequest(const HttpRequest& aRequest, IServerEndpoint& ep, ConnectionHdl hdl);
+
 		void handleHttpRequest(IServerEndpoint& ep, bool aIsSecure, ConnectionHdl hdl);
 
+		// Returns the path where the request body should be written (or an empty string if the body should be read in memory)
+		string handleHttpBodyFile(IServerEndpoint& ep, ConnectionHdl hdl) noexcept;
+
 		WebServerManager* wsm;
 		FileServer fileServer;
 	};
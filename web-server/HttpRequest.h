@@ -34,6 +34,8 @@ namespace webserver {
 		// Header accessor provided by the endpoint
 		std::function<std::string(const std::string&)> getHeader;
 		bool secure;
+		// Set if the body was written directly to a file by the endpoint (body is empty in that case)
+		std::string bodyFile;
 	};
 }
 
@@ -25,6 +25,11 @@
 #include <airdcpp/util/Util.h>
 
 #include "boost/algorithm/string/replace.hpp"
+#include "boost/algorithm/string/trim.hpp"
+
+#include <ctime>
+#include <iomanip>
+#include <sstream>
 
 
 namespace webserver {
@@ -130,6 +135,79 @@ namespace webserver {
 		headers_.emplace_back("Cache-Control", aDaysValid == 0 ? "no-store" : "max-age=" + Util::toString(aDaysValid * 24 * 60 * 60));
 	}
 
+	bool HttpUtil::acceptsEncoding(const string& aAcceptEncoding, const string& aEncoding) noexcept {
+		for (const auto& token: StringTokenizer<string>(aAcceptEncoding, ',').getTokens()) {
+			auto params = StringTokenizer<string>(token, ';').getTokens();
+			if (params.empty()) {
+				continue;
+			}
+
+			auto name = boost::algorithm::trim_copy(params.front());
+			if (Util::stricmp(name, aEncoding) != 0) {
+				continue;
+			}
+
+			// Explicitly refused?
+			auto refused = false;
+			for (auto i = params.begin() + 1; i != params.end(); ++i) {
+				auto param = boost::algorithm::trim_copy(*i);
+				if (param.starts_with("q=") && Util::toDouble(param.substr(2)) <= 0) {
+					refused = true;
+				}
+			}
+
+			return !refused;
+		}
+
+		return false;
+	}
+
+	bool HttpUtil::matchETag(const string& aIfNoneMatch, const string& aETag) noexcept {
+		for (auto tag: StringTokenizer<string>(aIfNoneMatch, ',').getTokens()) {
+			boost::algorithm::trim(tag);
+
+			// Weak comparison is used for If-None-Match
+			if (tag.starts_with("W/")) {
+				tag = tag.substr(2);
+			}
+
+			if (tag == aETag || tag == "*") {
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	string HttpUtil::formatHttpDate(time_t aTime) noexcept {
+		std::tm tm {};
+#ifdef _WIN32
+		gmtime_s(&tm, &aTime);
+#else
+		gmtime_r(&aTime, &tm);
+#endif
+
+		char buf[64];
+		auto len = std::strftime(buf, sizeof(buf), "%a, %d %b %Y %H:%M:%S GMT", &tm);
+		return string(buf, len);
+	}
+
+	time_t HttpUtil::parseHttpDate(const string& aDate) noexcept {
+		std::tm tm {};
+		std::istringstream is(aDate);
+		is.imbue(std::locale::classic());
+		is >> std::get_time(&tm, "%a, %d %b %Y %H:%M:%S");
+		if (is.fail()) {
+			return 0;
+		}
+
+#ifdef _WIN32
+		return _mkgmtime(&tm);
+#else
+		return timegm(&tm);
+#endif
+	}
+
 	string HttpUtil::formatPartialRange(int64_t aStartPos, int64_t aEndPos, int64_t aFileSize) noexcept {
 		dcassert(aEndPos < aFileSize);
 		return "bytes " + Util::toString(aStartPos) + "-" + Util::toString(aEndPos) + "/" + Util::toString(aFileSize);
@@ -40,6 +40,19 @@ namespace webserver {
 
 		static void addCacheControlHeader(StringPairList& headers_, int aDaysValid) noexcept;
 
+		// Returns true if the encoding is listed in the Accept-Encoding header value (and it doesn't have a q-value of 0)
+		static bool acceptsEncoding(const string& aAcceptEncoding, const string& aEncoding) noexcept;
+
+		// Conditional requests
+		// Returns true if the If-None-Match header value contains the (strong) ETag or "*"
+		static bool matchETag(const string& aIfNoneMatch, const string& aETag) noexcept;
+
+		// RFC 7231 IMF-fixdate format (e.g. "Sun, 06 Nov 1994 08:49:37 GMT")
+		static string formatHttpDate(time_t aTime) noexcept;
+
+		// Returns 0 if the date couldn't be parsed
+		static time_t parseHttpDate(const string& aDate) noexcept;
+
 		static bool isStatusOk(http::status aCode) noexcept;
 		static bool parseStatus(const string& aResponse, http::status& code_, string& text_) noexcept;
 		static string parseAuthToken(const string& authorizationHeader, const string& xAuthorizationHeader) noexcept;
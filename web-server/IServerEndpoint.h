@@ -9,10 +9,54 @@
 #include <functional>
 #include <memory>
 #include <string>
+#include <string_view>
 
 namespace webserver {
 	using contextPtr = std::shared_ptr<boost::asio::ssl::context>;
 
+	// Response body that is streamed from a file by the endpoint (the file isn't loaded in memory)
+	struct HttpFileBody {
+		std::string path;
+		int64_t start = 0;
+		int64_t length = 0;
+
+		// Cached file content (written without copying, the path is informational in that case)
+		std::shared_ptr<const std::string> buffer;
+	};
+
+	// Information about an outgoing WebSocket message, used when the outgoing queue of a slow client is full
+	struct WsMessageInfo {
+		// Queued messages with the same key are replaced by newer ones (the message contains the full state of the item)
+		std::string supersedeKey;
+
+		// The message may be dropped (only events whose state is delivered again by later events, e.g. ticks)
+		bool droppable = false;
+
+		// Send as a binary frame
+		bool binary = false;
+	};
+
+	enum class WsSendQueuePolicy {
+		// Replace superseded queued messages, disconnect if the queue is still full
+		COALESCE,
+
+		// Replace superseded queued messages and drop droppable messages, disconnect if the queue is still full
+		DROP,
+
+		// Disconnect the client immediately when the queue is full
+		DISCONNECT,
+	};
+
+	// Totals for all WebSocket connections of an endpoint
+	struct WsSendQueueStats {
+		std::uint64_t queuedMessages = 0;
+		std::uint64_t queuedBytes = 0;
+
+		std::uint64_t coalescedMessages = 0;
+		std::uint64_t droppedMessages = 0;
+		std::uint64_t disconnectedClients = 0;
+	};
+
 	class IServerEndpoint {
 	public:
 		virtual ~IServerEndpoint() = default;
@@ -24,6 +68,19 @@ namespace webserver {
 		virtual void setOpenHandshakeTimeout(int millis) = 0;
 		virtual void setPongTimeout(int millis) = 0;
 		virtual void setMaxHttpBodySize(std::size_t bytes) = 0;
+		virtual void setMaxHttpUploadSize(std::uint64_t bytes) = 0;
+
+		// Persistent HTTP connections (idle timeout of 0 disables keep-alive, max requests of 0 means unlimited)
+		virtual void setHttpKeepAlive(int idleTimeoutMillis, int maxRequests) = 0;
+
+		// WebSocket permessage-deflate (window bits of 0 disables compression, other values are clamped to 9-15; smaller messages are sent uncompressed)
+		virtual void setWsCompression(int windowBits, int memLevel, std::size_t minMessageSize) = 0;
+
+		// WebSocket subprotocols that may be selected during the handshake (the first one requested by the client is used)
+		virtual void setWsSubprotocols(const std::vector<std::string>& subprotocols) = 0;
+
+		// Per-connection limits for the outgoing WebSocket message queue (0 means unlimited)
+		virtual void setWsSendQueueLimits(std::size_t maxBytes, std::size_t maxMessages, WsSendQueuePolicy policy) = 0;
 
 		// TLS init (no handle is required by the current user code)
 		virtual void setTlsInitHandler(std::function<contextPtr()> handler) = 0;
@@ -40,8 +97,13 @@ namespace webserver {
 		virtual void stopListening() = 0;
 
 		// Event handlers
-		virtual void setMessageHandler(std::function<void(ConnectionHdl, const std::string&)> onMessage) = 0;
+		// The message points to the read buffer of the connection (it's valid only during the call)
+		virtual void setMessageHandler(std::function<void(ConnectionHdl, std::string_view)> onMessage) = 0;
 		virtual void setHttpHandler(std::function<void(ConnectionHdl)> onHttp) = 0;
+
+		// Called after the request headers have been received
+		// Return a file path to have the request body written directly to a file instead of reading it in memory
+		virtual void setHttpBodyFileHandler(std::function<std::string(ConnectionHdl)> onBodyFile) = 0;
 		virtual void setCloseHandler(std::function<void(ConnectionHdl)> onClose) = 0;
 		virtual void setOpenHandler(std::function<void(ConnectionHdl)> onOpen) = 0;
 		virtual void setPongTimeoutHandler(std::function<void(ConnectionHdl, const std::string&)> onPongTimeout) = 0;
@@ -51,19 +113,28 @@ namespace webserver {
 		// Generic HTTP request accessors (adapter-agnostic)
 		virtual std::string getHeader(ConnectionHdl hdl, const std::string& name) = 0;
 		virtual std::string getBody(ConnectionHdl hdl) = 0;
+		virtual std::string getBodyFilePath(ConnectionHdl hdl) = 0;
 		virtual std::string getMethod(ConnectionHdl hdl) = 0;
 		virtual std::string getUri(ConnectionHdl hdl) = 0;
 		virtual std::string getResource(ConnectionHdl hdl) = 0;
 
+		// Subprotocol selected during the WebSocket handshake (empty if the client didn't request a supported one)
+		virtual std::string getWsSubprotocol(ConnectionHdl hdl) = 0;
+
 		// HTTP response helpers
 		virtual void httpAppendHeader(ConnectionHdl hdl, const std::string& name, const std::string& value) = 0;
 		virtual void httpSetBody(ConnectionHdl hdl, const std::string& body) = 0;
+		virtual void httpSetFileBody(ConnectionHdl hdl, const HttpFileBody& body) = 0;
 		virtual void httpSetStatus(ConnectionHdl hdl, http::status status) = 0;
 		virtual void httpDeferResponse(ConnectionHdl hdl) = 0;
 		virtual void httpSendResponse(ConnectionHdl hdl) = 0;
 
 		// WebSocket helpers
-		virtual void wsSendText(ConnectionHdl hdl, const std::string& text) = 0;
+		virtual void wsSendText(ConnectionHdl hdl, std::string&& text, const WsMessageInfo& info) = 0;
+
+		// The same buffer may be queued for multiple connections
+		virtual void wsSendShared(ConnectionHdl hdl, const std::shared_ptr<const std::string>& text, const WsMessageInfo& info) = 0;
+		virtual WsSendQueueStats getWsSendQueueStats() const noexcept = 0;
 		virtual void wsPing(ConnectionHdl hdl) = 0;
 		virtual void wsClose(ConnectionHdl hdl, uint16_t code, const std::string& reason) = 0;
 	};
@@ -0,0 +1,227 @@
+/*
+* Copyright (C) 2011-2024 AirDC++ Project
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+*/
+
+#include "stdinc.h"
+
+#include <web-server/JsonWriter.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace webserver {
+	void JsonWriter::beforeValue() noexcept {
+		if (afterKey) {
+			// The separator was written with the key
+			afterKey = false;
+			return;
+		}
+
+		if (!hasValues.empty()) {
+			if (hasValues.back()) {
+				out.push_back(',');
+			} else {
+				hasValues.back() = true;
+			}
+		}
+	}
+
+	void JsonWriter::start(char aBracket) noexcept {
+		beforeValue();
+		out.push_back(aBracket);
+		hasValues.push_back(false);
+	}
+
+	void JsonWriter::end(char aBracket) noexcept {
+		dcassert(!hasValues.empty() && !afterKey);
+		out.push_back(aBracket);
+		hasValues.pop_back();
+	}
+
+	void JsonWriter::startObject() noexcept {
+		start('{');
+	}
+
+	void JsonWriter::endObject() noexcept {
+		end('}');
+	}
+
+	void JsonWriter::startArray() noexcept {
+		start('[');
+	}
+
+	void JsonWriter::endArray() noexcept {
+		end(']');
+	}
+
+	void JsonWriter::key(std::string_view aKey) noexcept {
+		beforeValue();
+		escapeString(aKey, out);
+		out.push_back(':');
+		afterKey = true;
+	}
+
+	void JsonWriter::escapedKey(const string& aEscapedKey) noexcept {
+		beforeValue();
+		out += aEscapedKey;
+		afterKey = true;
+	}
+
+	void JsonWriter::value(std::string_view aValue) noexcept {
+		beforeValue();
+		escapeString(aValue, out);
+	}
+
+	void JsonWriter::value(double aValue) noexcept {
+		beforeValue();
+		if (!std::isfinite(aValue)) {
+			out += "null";
+			return;
+		}
+
+		char buf[32];
+		auto res = std::to_chars(buf, buf + sizeof(buf), aValue);
+		out.append(buf, res.ptr);
+
+		// Floating point values are always written with a decimal part (as with json::dump)
+		if (std::find_if(buf, res.ptr, [](char c) { return c == '.' || c == 'e'; }) == res.ptr) {
+			out += ".0";
+		}
+	}
+
+	void JsonWriter::value(bool aValue) noexcept {
+		beforeValue();
+		out += aValue ? "true" : "false";
+	}
+
+	void JsonWriter::value(const json& aValue) {
+		auto str = aValue.dump();
+
+		beforeValue();
+		out += str;
+	}
+
+	void JsonWriter::nullValue() noexcept {
+		beforeValue();
+		out += "null";
+	}
+
+	void JsonWriter::rawValue(std::string_view aJson) noexcept {
+		beforeValue();
+		out += aJson;
+	}
+
+	string JsonWriter::escapeKey(std::string_view aKey) noexcept {
+		string ret;
+		escapeString(aKey, ret);
+		ret.push_back(':');
+		return ret;
+	}
+
+	// Length of a valid UTF-8 sequence starting at aPos (0 if the sequence is invalid)
+	static size_t getUtf8SequenceLength(std::string_view aStr, size_t aPos) noexcept {
+		const auto lead = static_cast<unsigned char>(aStr[aPos]);
+
+		size_t length;
+		unsigned char min = 0x80, max = 0xBF;
+		if (lead >= 0xC2 && lead <= 0xDF) {
+			length = 2;
+		} else if (lead >= 0xE0 && lead <= 0xEF) {
+			length = 3;
+			if (lead == 0xE0) min = 0xA0;
+			else if (lead == 0xED) max = 0x9F; // Surrogates
+		} else if (lead >= 0xF0 && lead <= 0xF4) {
+			length = 4;
+			if (lead == 0xF0) min = 0x90;
+			else if (lead == 0xF4) max = 0x8F;
+		} else {
+			return 0;
+		}
+
+		if (aPos + length > aStr.size()) {
+			return 0;
+		}
+
+		for (size_t i = 1; i < length; i++) {
+			const auto c = static_cast<unsigned char>(aStr[aPos + i]);
+			if (c < (i == 1 ? min : 0x80) || c > (i == 1 ? max : 0xBF)) {
+				return 0;
+			}
+		}
+
+		return length;
+	}
+
+	void JsonWriter::escapeString(std::string_view aStr, string& out_) noexcept {
+		static const char hexChars[] = "0123456789abcdef";
+
+		out_.push_back('"');
+
+		size_t pos = 0;
+		while (pos < aStr.size()) {
+			// Copy characters that don't need escaping in one go
+			auto runEnd = pos;
+			while (runEnd < aStr.size()) {
+				const auto c = static_cast<unsigned char>(aStr[runEnd]);
+				if (c < 0x20 || c == '"' || c == '\\' || c >= 0x80) {
+					break;
+				}
+
+				runEnd++;
+			}
+
+			out_.append(aStr.data() + pos, runEnd - pos);
+			pos = runEnd;
+			if (pos == aStr.size()) {
+				break;
+			}
+
+			const auto c = static_cast<unsigned char>(aStr[pos]);
+			if (c >= 0x80) {
+				auto length = getUtf8SequenceLength(aStr, pos);
+				if (length == 0) {
+					out_ += "\xEF\xBF\xBD";
+					pos++;
+				} else {
+					out_.append(aStr.data() + pos, length);
+					pos += length;
+				}
+
+				continue;
+			}
+
+			switch (c) {
+				case '"': out_ += "\\\""; break;
+				case '\\': out_ += "\\\\"; break;
+				case '\b': out_ += "\\b"; break;
+				case '\f': out_ += "\\f"; break;
+				case '\n': out_ += "\\n"; break;
+				case '\r': out_ += "\\r"; break;
+				case '\t': out_ += "\\t"; break;
+				default: {
+					out_ += "\\u00";
+					out_.push_back(hexChars[c >> 4]);
+					out_.push_back(hexChars[c & 0xF]);
+				}
+			}
+
+			pos++;
+		}
+
+		out_.push_back('"');
+	}
+}
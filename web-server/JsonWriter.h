@@ -0,0 +1,104 @@
+/*
+* Copyright (C) 2011-2024 AirDC++ Project
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+*/
+
+#ifndef DCPLUSPLUS_WEBSERVER_JSONWRITER_H
+#define DCPLUSPLUS_WEBSERVER_JSONWRITER_H
+
+#include "forward.h"
+
+#include <airdcpp/core/header/typedefs.h>
+
+#include <charconv>
+#include <string_view>
+#include <type_traits>
+
+namespace webserver {
+	// Writes JSON directly into a string buffer without building a json object tree
+	// The output is equal to json::dump() (except for the order of object keys)
+	// Invalid UTF-8 sequences are replaced with U+FFFD
+	class JsonWriter {
+	public:
+		// The output buffer may be reused between writes (the content is appended)
+		explicit JsonWriter(string& out_) noexcept : out(out_) { }
+
+		void startObject() noexcept;
+		void endObject() noexcept;
+		void startArray() noexcept;
+		void endArray() noexcept;
+
+		void key(std::string_view aKey) noexcept;
+
+		// Key created with escapeKey (property names are escaped only once)
+		void escapedKey(const string& aEscapedKey) noexcept;
+
+		void value(const string& aValue) noexcept {
+			value(std::string_view(aValue));
+		}
+
+		void value(const char* aValue) noexcept {
+			value(std::string_view(aValue));
+		}
+
+		void value(std::string_view aValue) noexcept;
+		void value(double aValue) noexcept;
+		void value(bool aValue) noexcept;
+
+		template<class T>
+		requires (std::is_integral_v<T> && !std::is_same_v<T, bool>)
+		void value(T aValue) noexcept {
+			beforeValue();
+
+			char buf[24];
+			auto res = std::to_chars(buf, buf + sizeof(buf), aValue);
+			out.append(buf, res.ptr);
+		}
+
+		// Other types are serialized with the json library
+		void value(const json& aValue);
+
+		void nullValue() noexcept;
+
+		// Appends a serialized JSON value
+		void rawValue(std::string_view aJson) noexcept;
+
+		template<class T>
+		void field(std::string_view aKey, const T& aValue) {
+			key(aKey);
+			value(aValue);
+		}
+
+		// Returns the key with quotes and the name separator
+		static string escapeKey(std::string_view aKey) noexcept;
+		static void escapeString(std::string_view aStr, string& out_) noexcept;
+
+		JsonWriter(JsonWriter&) = delete;
+		JsonWriter& operator=(JsonWriter&) = delete;
+	private:
+		void beforeValue() noexcept;
+		void start(char aBracket) noexcept;
+		void end(char aBracket) noexcept;
+
+		string& out;
+
+		// Whether the current container has values (no separator is needed before the first one)
+		std::vector<bool> hasValues;
+		bool afterKey = false;
+	};
+}
+
+#endif
@@ -0,0 +1,145 @@
+/*
+* Copyright (C) 2011-2024 AirDC++ Project
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+*/
+
+#include "stdinc.h"
+
+#include <web-server/RateLimiter.h>
+#include <web-server/WebServerSettings.h>
+
+#include <cmath>
+
+// Bucket size as seconds of the refill rate
+#define INTERACTIVE_BURST_SECONDS 4
+#define BULK_BURST_SECONDS 5
+
+// How often to check for idle buckets (admissions)
+#define IDLE_CHECK_INTERVAL 1024
+
+namespace webserver {
+	RateLimiter::RateLimiter(WebServerSettings& aSettings) noexcept : settings(aSettings) {
+
+	}
+
+	void RateLimiter::Bucket::refill(const Budget& aBudget, Clock::time_point aNow) noexcept {
+		if (!initialized) {
+			tokens = aBudget.burst;
+			initialized = true;
+		} else {
+			const auto elapsed = std::chrono::duration<double>(aNow - updated).count();
+			tokens = std::min(aBudget.burst, tokens + elapsed * aBudget.tokensPerSecond);
+		}
+
+		updated = aNow;
+	}
+
+	uint64_t RateLimiter::Bucket::getWaitTime(const Budget& aBudget, int aCost) const noexcept {
+		const auto remaining = tokens - aCost;
+		if (remaining >= 0) {
+			return 0;
+		}
+
+		// Tokens may go negative for queued requests, following requests will have to wait longer
+		return static_cast<uint64_t>(std::ceil(-remaining * 1000 / aBudget.tokensPerSecond));
+	}
+
+	bool RateLimiter::Bucket::isIdle(const Budget& aBudget, Clock::time_point aNow) const noexcept {
+		const auto elapsed = std::chrono::duration<double>(aNow - updated).count();
+		return tokens + elapsed * aBudget.tokensPerSecond >= aBudget.burst;
+	}
+
+	std::optional<uint64_t> RateLimiter::admit(LocalSessionId aSessionId, const string& aUserName, int aCost) noexcept {
+		if (!isEnabled()) {
+			return 0;
+		}
+
+		const auto routeClass = getRouteClass(aCost);
+		const auto classIndex = static_cast<size_t>(routeClass);
+		const auto now = Clock::now();
+
+		Lock l(cs);
+		if (++admissionCounter % IDLE_CHECK_INTERVAL == 0) {
+			removeIdleBuckets(now);
+		}
+
+		auto& sessionBucket = sessionBuckets[aSessionId][classIndex];
+		auto& userBucket = userBuckets[aUserName][classIndex];
+
+		const auto sessionBudget = getBudget(Scope::SESSION, routeClass);
+		const auto userBudget = getBudget(Scope::USER, routeClass);
+
+		sessionBucket.refill(sessionBudget, now);
+		userBucket.refill(userBudget, now);
+
+		const auto waitTime = std::max(sessionBucket.getWaitTime(sessionBudget, aCost), userBucket.getWaitTime(userBudget, aCost));
+		if (waitTime > getMaxQueueTime()) {
+			stats.rejected++;
+			return std::nullopt;
+		}
+
+		sessionBucket.tokens -= aCost;
+		userBucket.tokens -= aCost;
+
+		if (waitTime > 0) {
+			stats.queued++;
+		} else {
+			stats.admitted++;
+		}
+
+		return waitTime;
+	}
+
+	void RateLimiter::removeIdleBuckets(Clock::time_point aNow) noexcept {
+		auto removeIdle = [&](auto& aBuckets, Scope aScope) {
+			std::erase_if(aBuckets, [&](const auto& aItem) {
+				for (size_t i = 0; i < aItem.second.size(); i++) {
+					if (!aItem.second[i].isIdle(getBudget(aScope, static_cast<RouteClass>(i)), aNow)) {
+						return false;
+					}
+				}
+
+				return true;
+			});
+		};
+
+		removeIdle(sessionBuckets, Scope::SESSION);
+		removeIdle(userBuckets, Scope::USER);
+	}
+
+	bool RateLimiter::isEnabled() const noexcept {
+		return settings.getSettingItem(WebServerSettings::RATE_LIMIT_ENABLED).boolean();
+	}
+
+	RateLimiter::Budget RateLimiter::getBudget(Scope aScope, RouteClass aClass) const noexcept {
+		const auto bulk = aClass == RouteClass::BULK;
+		const auto setting = aScope == Scope::SESSION ?
+			(bulk ? WebServerSettings::RATE_LIMIT_SESSION_BULK_REQUESTS : WebServerSettings::RATE_LIMIT_SESSION_REQUESTS) :
+			(bulk ? WebServerSettings::RATE_LIMIT_USER_BULK_REQUESTS : WebServerSettings::RATE_LIMIT_USER_REQUESTS);
+
+		const double tokensPerSecond = settings.getSettingItem(setting).num();
+		return { tokensPerSecond, tokensPerSecond * (bulk ? BULK_BURST_SECONDS : INTERACTIVE_BURST_SECONDS) };
+	}
+
+	uint64_t RateLimiter::getMaxQueueTime() const noexcept {
+		return settings.getSettingItem(WebServerSettings::RATE_LIMIT_MAX_QUEUE_TIME).uint64() * 1000;
+	}
+
+	RateLimiter::Stats RateLimiter::getStats() const noexcept {
+		Lock l(cs);
+		return stats;
+	}
+}
@@ -0,0 +1,115 @@
+/*
+* Copyright (C) 2011-2024 AirDC++ Project
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+*/
+
+#ifndef DCPLUSPLUS_WEBSERVER_RATELIMITER_H
+#define DCPLUSPLUS_WEBSERVER_RATELIMITER_H
+
+#include "forward.h"
+
+#include <airdcpp/core/thread/CriticalSection.h>
+
+#include <array>
+#include <chrono>
+#include <optional>
+#include <unordered_map>
+
+namespace webserver {
+	class WebServerSettings;
+
+	// Token bucket admission control for API requests
+	// Each session and user has separate buckets for interactive and bulk (costly) requests so that 
+	// clients running heavy operations won't block the regular UI traffic
+	class RateLimiter {
+	public:
+		enum class RouteClass : uint8_t {
+			INTERACTIVE,
+			BULK,
+			LAST
+		};
+
+		enum class Scope : uint8_t {
+			SESSION,
+			USER,
+			LAST
+		};
+
+		struct Budget {
+			double tokensPerSecond;
+			double burst;
+		};
+
+		struct Stats {
+			uint64_t admitted = 0;
+			uint64_t queued = 0;
+			uint64_t rejected = 0;
+		};
+
+		// Budgets and the maximum queue time are read from the web server settings
+		explicit RateLimiter(WebServerSettings& aSettings) noexcept;
+
+		static RouteClass getRouteClass(int aCost) noexcept {
+			return aCost > 1 ? RouteClass::BULK : RouteClass::INTERACTIVE;
+		}
+
+		// Reserves aCost tokens from the session and user buckets
+		// Returns the time (in milliseconds) that the request should be queued for before handling it (0 = no queueing),
+		// std::nullopt is returned if the request can't be handled within the maximum queue time
+		std::optional<uint64_t> admit(LocalSessionId aSessionId, const string& aUserName, int aCost) noexcept;
+
+		// Admission control is disabled by default
+		bool isEnabled() const noexcept;
+
+		Budget getBudget(Scope aScope, RouteClass aClass) const noexcept;
+
+		Stats getStats() const noexcept;
+
+		RateLimiter(RateLimiter&) = delete;
+		RateLimiter& operator=(RateLimiter&) = delete;
+	private:
+		using Clock = std::chrono::steady_clock;
+
+		struct Bucket {
+			double tokens = 0;
+			Clock::time_point updated;
+			bool initialized = false;
+
+			void refill(const Budget& aBudget, Clock::time_point aNow) noexcept;
+
+			// Milliseconds until aCost tokens are available
+			uint64_t getWaitTime(const Budget& aBudget, int aCost) const noexcept;
+			bool isIdle(const Budget& aBudget, Clock::time_point aNow) const noexcept;
+		};
+
+		using BucketList = std::array<Bucket, static_cast<size_t>(RouteClass::LAST)>;
+
+		uint64_t getMaxQueueTime() const noexcept;
+		void removeIdleBuckets(Clock::time_point aNow) noexcept;
+
+		mutable CriticalSection cs;
+
+		std::unordered_map<LocalSessionId, BucketList> sessionBuckets;
+		std::unordered_map<string, BucketList> userBuckets;
+
+		WebServerSettings& settings;
+		uint64_t admissionCounter = 0;
+
+		Stats stats;
+	};
+}
+
+#endif
@@ -19,6 +19,9 @@
 #include "stdinc.h"
 #include <web-server/Session.h>
 #include <web-server/ApiRequest.h>
+#include <web-server/WebServerManager.h>
+#include <web-server/WebUser.h>
+#include <web-server/WebUserManager.h>
 
 #include <api/AdcCommandApi.h>
 #include <api/ConnectivityApi.h>
@@ -49,9 +52,50 @@
 #include <airdcpp/core/timer/TimerManager.h>
 #include <airdcpp/util/ValueGenerator.h>
 
+#include <chrono>
 
 namespace webserver {
-#define ADD_MODULE(name, type) (apiHandlers.emplace(name, LazyModuleWrapper([this] { return make_unique<type>(this); })))
+	template<class T>
+	static unique_ptr<ApiModule> createModule(Session* aSession) {
+		return make_unique<T>(aSession);
+	}
+
+	struct ModuleInfo {
+		std::string_view id;
+		unique_ptr<ApiModule> (*create)(Session* aSession);
+
+		// Permission required for using the module (modules aren't initialized in advance for other users)
+		Access access;
+	};
+
+	// Indexed by Session::ModuleId
+	static const std::array<ModuleInfo, Session::MODULE_COUNT> moduleInfos = {{
+		{ "adc_commands", createModule<AdcCommandApi>, Access::ADMIN },
+		{ "connectivity", createModule<ConnectivityApi>, Access::SETTINGS_VIEW },
+		{ "extensions", createModule<ExtensionApi>, Access::SETTINGS_VIEW },
+		{ "events", createModule<EventApi>, Access::EVENTS_VIEW },
+		{ "favorite_directories", createModule<FavoriteDirectoryApi>, Access::ANY },
+		{ "favorite_hubs", createModule<FavoriteHubApi>, Access::FAVORITE_HUBS_VIEW },
+		{ "filelists", createModule<FilelistApi>, Access::FILELISTS_VIEW },
+		{ "filesystem", createModule<FilesystemApi>, Access::FILESYSTEM_VIEW },
+		{ "hash", createModule<HashApi>, Access::SHARE_VIEW },
+		{ "histories", createModule<HistoryApi>, Access::ANY },
+		{ "hubs", createModule<HubApi>, Access::HUBS_VIEW },
+		{ "menus", createModule<MenuApi>, Access::ANY },
+		{ "private_chat", createModule<PrivateChatApi>, Access::PRIVATE_CHAT_VIEW },
+		{ "queue", createModule<QueueApi>, Access::QUEUE_VIEW },
+		{ "search", createModule<SearchApi>, Access::SEARCH },
+		{ "sessions", createModule<SessionApi>, Access::ADMIN },
+		{ "settings", createModule<SettingApi>, Access::ANY },
+		{ "share", createModule<ShareApi>, Access::SHARE_VIEW },
+		{ "share_profiles", createModule<ShareProfileApi>, Access::ANY },
+		{ "share_roots", createModule<ShareRootApi>, Access::SHARE_VIEW },
+		{ "system", createModule<SystemApi>, Access::ANY },
+		{ "transfers", createModule<TransferApi>, Access::TRANSFERS },
+		{ "users", createModule<UserApi>, Access::ANY },
+		{ "web_users", createModule<WebUserApi>, Access::ADMIN },
+		{ "view_files", createModule<ViewFileApi>, Access::VIEW_FILES_VIEW },
+	}};
 
 	Session::Session(const WebUserPtr& aUser, const string& aToken, SessionType aSessionType, WebServerManager* aServer, uint64_t maxInactivityMinutes, const string& aIP) :
 		maxInactivity(maxInactivityMinutes*1000*60), started(GET_TICK()), lastActivity(GET_TICK()), id(ValueGenerator::rand()), 
@@ -59,41 +103,60 @@ namespace webserver {
 		user(aUser),
 		server(aServer) {
 
-		ADD_MODULE("adc_commands", AdcCommandApi);
-		ADD_MODULE("connectivity", ConnectivityApi);
-		ADD_MODULE("extensions", ExtensionApi);
-		ADD_MODULE("events", EventApi);
-		ADD_MODULE("favorite_directories", FavoriteDirectoryApi);
-		ADD_MODULE("favorite_hubs", FavoriteHubApi);
-		ADD_MODULE("filelists", FilelistApi);
-		ADD_MODULE("filesystem", FilesystemApi);
-		ADD_MODULE("hash", HashApi);
-		ADD_MODULE("histories", HistoryApi);
-		ADD_MODULE("hubs", HubApi);
-		ADD_MODULE("menus", MenuApi);
-		ADD_MODULE("private_chat", PrivateChatApi);
-		ADD_MODULE("queue", QueueApi);
-		ADD_MODULE("search", SearchApi);
-		ADD_MODULE("sessions", SessionApi);
-		ADD_MODULE("settings", SettingApi);
-		ADD_MODULE("share", ShareApi);
-		ADD_MODULE("share_profiles", ShareProfileApi);
-		ADD_MODULE("share_roots", ShareRootApi);
-		ADD_MODULE("system", SystemApi);
-		ADD_MODULE("transfers", TransferApi);
-		ADD_MODULE("users", UserApi);
-		ADD_MODULE("web_users", WebUserApi);
-		ADD_MODULE("view_files", ViewFileApi);
 	}
 
 	Session::~Session() {
 		dcdebug("Session %s was deleted\n", token.c_str());
 	}
 
-	ApiModule* Session::getModule(const string& aModule) {
-		Lock l(cs); // Avoid races when modules are being initialized by LazyModuleWrapper
-		auto h = apiHandlers.find(aModule);
-		return h != apiHandlers.end() ? h->second.get() : nullptr;
+	std::optional<Session::ModuleId> Session::parseModuleId(std::string_view aApiID) noexcept {
+		for (size_t i = 0; i < MODULE_COUNT; i++) {
+			if (moduleInfos[i].id == aApiID) {
+				return static_cast<ModuleId>(i);
+			}
+		}
+
+		return std::nullopt;
+	}
+
+	ApiModule* Session::getModule(std::string_view aApiID) {
+		auto moduleId = parseModuleId(aApiID);
+		return moduleId ? getModule(*moduleId) : nullptr;
+	}
+
+	ApiModule* Session::getModule(ModuleId aId) {
+		const auto index = static_cast<size_t>(aId);
+		auto apiModule = modules[index].load(std::memory_order_acquire);
+		if (!apiModule) {
+			// Other threads accessing the same module will wait until it has been constructed
+			std::call_once(moduleInitFlags[index], &Session::initModule, this, aId);
+			apiModule = modules[index].load(std::memory_order_acquire);
+		}
+
+		return apiModule;
+	}
+
+	void Session::initModule(ModuleId aId) {
+		const auto index = static_cast<size_t>(aId);
+
+		const auto start = std::chrono::steady_clock::now();
+		moduleOwners[index] = moduleInfos[index].create(this);
+		const auto duration = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+
+		modules[index].store(moduleOwners[index].get(), std::memory_order_release);
+		server->getUserManager().onModuleInitialized(string(moduleInfos[index].id), static_cast<uint64_t>(duration.count()));
+	}
+
+	void Session::initModules(const StringList& aModules) noexcept {
+		for (const auto& m: aModules) {
+			auto moduleId = parseModuleId(m);
+			if (!moduleId || !user->hasPermission(moduleInfos[static_cast<size_t>(*moduleId)].access)) {
+				// The module would be added only for rejecting the requests
+				continue;
+			}
+
+			getModule(*moduleId);
+		}
 	}
 
 	http::status Session::handleRequest(ApiRequest& aRequest) {
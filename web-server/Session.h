@@ -21,7 +21,6 @@
 
 #include "forward.h"
 
-#include <web-server/LazyInitWrapper.h>
 #include <web-server/SessionListener.h>
 
 #include <api/base/ApiModule.h>
@@ -31,6 +30,11 @@
 #include <airdcpp/core/header/typedefs.h>
 #include <airdcpp/core/Speaker.h>
 
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <optional>
+
 namespace webserver {
 	// Sessions are owned by WebUserManager and WebSockets (websockets are closed when session is removed)
 	class Session : public Speaker<SessionListener> {
@@ -42,6 +46,40 @@ namespace webserver {
 			TYPE_EXTENSION,
 		};
 
+		enum class ModuleId : uint8_t {
+			ADC_COMMANDS,
+			CONNECTIVITY,
+			EXTENSIONS,
+			EVENTS,
+			FAVORITE_DIRECTORIES,
+			FAVORITE_HUBS,
+			FILELISTS,
+			FILESYSTEM,
+			HASH,
+			HISTORIES,
+			HUBS,
+			MENUS,
+			PRIVATE_CHAT,
+			QUEUE,
+			SEARCH,
+			SESSIONS,
+			SETTINGS,
+			SHARE,
+			SHARE_PROFILES,
+			SHARE_ROOTS,
+			SYSTEM,
+			TRANSFERS,
+			USERS,
+			WEB_USERS,
+			VIEW_FILES,
+			LAST
+		};
+
+		static constexpr size_t MODULE_COUNT = static_cast<size_t>(ModuleId::LAST);
+
+		// Returns std::nullopt for unknown IDs
+		static std::optional<ModuleId> parseModuleId(std::string_view aApiID) noexcept;
+
 		Session(const WebUserPtr& aUser, const std::string& aToken, SessionType aSessionType, WebServerManager* aServer, uint64_t maxInactivityMinutes, const string& aIP);
 		~Session() override;
 
@@ -61,7 +99,14 @@ namespace webserver {
 			return sessionType;
 		}
 
-		ApiModule* getModule(const std::string& aApiID);
+		// The module is constructed on first access
+		// Lookups of constructed modules don't take any locks
+		ApiModule* getModule(ModuleId aId);
+		ApiModule* getModule(std::string_view aApiID);
+
+		// Construct the listed modules in advance so that the first requests won't have to wait for them
+		// Unknown module IDs and modules that the user doesn't have access to are ignored
+		void initModules(const StringList& aModules) noexcept;
 
 		http::status handleRequest(ApiRequest& aRequest);
 
@@ -90,7 +135,19 @@ namespace webserver {
 
 		void reportError(const string& aError) noexcept;
 		bool isTimeout(uint64_t aTick) const noexcept;
+
+		// Requests of the socket are run in the request thread pool instead of handling them in order in the socket thread
+		// Enabled by the client when authenticating the socket
+		bool getConcurrentRequests() const noexcept {
+			return concurrentRequests;
+		}
+
+		void setConcurrentRequests(bool aEnabled) noexcept {
+			concurrentRequests = aEnabled;
+		}
 	private:
+		std::atomic<bool> concurrentRequests = false;
+
 		const uint64_t maxInactivity;
 		const time_t started;
 
@@ -105,10 +162,12 @@ namespace webserver {
 		WebUserPtr user;
 		WebServerManager* server;
 
-		mutable CriticalSection cs;
+		// Published after the module has been fully constructed
+		std::array<std::atomic<ApiModule*>, MODULE_COUNT> modules {};
+		std::array<unique_ptr<ApiModule>, MODULE_COUNT> moduleOwners;
+		std::array<std::once_flag, MODULE_COUNT> moduleInitFlags;
 
-		using LazyModuleWrapper = LazyInitWrapper<ApiModule>;
-		std::map<std::string, LazyModuleWrapper> apiHandlers;
+		void initModule(ModuleId aId);
 	};
 }
 
@@ -60,27 +60,52 @@ namespace webserver {
 		disconnectSockets(STRING(WEB_SERVER_SHUTTING_DOWN));
 
 		for (;;) {
-			{
-				RLock l(cs);
-				if (sockets.empty()) {
-					break;
-				}
+			if (!hasSockets()) {
+				break;
 			}
 
 			Thread::sleep(50);
 		}
 	}
 
+	size_t SocketManager::getShardIndex(ConnectionHdl hdl) noexcept {
+		// The handle can always be locked in here as the endpoint calls the handlers only for open connections
+		auto connection = hdl.lock();
+		dcassert(connection);
+
+		auto address = reinterpret_cast<uintptr_t>(connection.get()) / alignof(std::max_align_t);
+		return std::hash<uintptr_t>()(address) % SOCKET_SHARD_COUNT;
+	}
+
 	WebSocketPtr SocketManager::getSocket(ConnectionHdl hdl) const noexcept {
-		RLock l(cs);
-		auto s = sockets.find(hdl);
-		if (s != sockets.end()) {
+		const auto& shard = shards[getShardIndex(hdl)];
+
+		RLock l(shard.cs);
+		auto s = shard.sockets.find(hdl);
+		if (s != shard.sockets.end()) {
 			return s->second;
 		}
 
 		return nullptr;
 	}
 
+	SocketManager::WebSocketList SocketManager::getSockets() const noexcept {
+		WebSocketList ret;
+		for (const auto& shard : shards) {
+			RLock l(shard.cs);
+			ranges::copy(shard.sockets | views::values, back_inserter(ret));
+		}
+
+		return ret;
+	}
+
+	bool SocketManager::hasSockets() const noexcept {
+		return ranges::any_of(shards, [](const SocketShard& aShard) {
+			RLock l(aShard.cs);
+			return !aShard.sockets.empty();
+		});
+	}
+
 	// For debugging only
 	void SocketManager::handlePongReceived(ConnectionHdl hdl, const string& /*aPayload*/) {
 		auto socket = getSocket(hdl);
@@ -111,15 +136,12 @@ namespace webserver {
 		vector<WebSocketPtr> inactiveSockets;
 		auto tick = GET_TICK();
 
-		{
-			RLock l(cs);
-			for (const auto& socket : sockets | views::values) {
-				socket->ping();
+		for (const auto& socket : getSockets()) {
+			socket->ping();
 
-				// Disconnect sockets without a session after one minute
-				if (!socket->getSession() && socket->getTimeCreated() + AUTHENTICATION_TIMEOUT * 1000ULL < tick) {
-					inactiveSockets.push_back(socket);
-				}
+			// Disconnect sockets without a session after one minute
+			if (!socket->getSession() && socket->getTimeCreated() + AUTHENTICATION_TIMEOUT * 1000ULL < tick) {
+				inactiveSockets.push_back(socket);
 			}
 		}
 
@@ -130,26 +152,24 @@ namespace webserver {
 	}
 
 	void SocketManager::disconnectSockets(const string& aMessage) noexcept {
-		RLock l(cs);
-		for (const auto& socket : sockets | views::values) {
+		for (const auto& socket : getSockets()) {
 			// 1001 going away
 			socket->close(static_cast<uint16_t>(websocket::close_code::going_away), aMessage);
 		}
 	}
 
 	WebSocketPtr SocketManager::getSocket(LocalSessionId aSessionToken) noexcept {
-		RLock l(cs);
-		auto i = ranges::find_if(sockets | views::values, [&](const WebSocketPtr& s) {
-			return s->getSession() && s->getSession()->getId() == aSessionToken;
-		});
-
-		return i.base() == sockets.end() ? nullptr : *i;
+		RLock l(sessionCs);
+		auto i = sessionSockets.find(aSessionToken);
+		return i == sessionSockets.end() ? nullptr : i->second;
 	}
 
 	void SocketManager::addSocket(ConnectionHdl hdl, const WebSocketPtr& aSocket) noexcept {
 		{
-			WLock l(cs);
-			sockets.try_emplace(hdl, aSocket);
+			auto& shard = shards[getShardIndex(hdl)];
+
+			WLock l(shard.cs);
+			shard.sockets.try_emplace(hdl, aSocket);
 		}
 
 		fire(SocketManagerListener::SocketConnected(), aSocket);
@@ -168,14 +188,16 @@ namespace webserver {
 		resetSocketSession(socket);
 
 		{
-			WLock l(cs);
-			auto s = sockets.find(hdl);
-			dcassert(s != sockets.end());
-			if (s == sockets.end()) {
+			auto& shard = shards[getShardIndex(hdl)];
+
+			WLock l(shard.cs);
+			auto s = shard.sockets.find(hdl);
+			dcassert(s != shard.sockets.end());
+			if (s == shard.sockets.end()) {
 				return;
 			}
 
-			sockets.erase(s);
+			shard.sockets.erase(s);
 		}
 
 		dcassert(socket.use_count() == 1);
@@ -191,8 +213,14 @@ namespace webserver {
 			oldSocket->close(static_cast<uint16_t>(websocket::close_code::policy_error), "Another socket was connected to this session");
 		}
 
-		aSession->onSocketConnected(aSocket);
+		// Register the socket before firing the event (modules created concurrently will look it up from here)
+		{
+			WLock l(sessionCs);
+			sessionSockets[aSession->getId()] = aSocket;
+		}
+
 		aSocket->setSession(aSession);
+		aSession->onSocketConnected(aSocket);
 	}
 
 	void SocketManager::on(WebUserManagerListener::SessionRemoved, const SessionPtr& aSession, int aReason) noexcept {
@@ -213,6 +241,15 @@ namespace webserver {
 	void SocketManager::resetSocketSession(const WebSocketPtr& aSocket) noexcept {
 		if (aSocket->getSession()) {
 			dcdebug("Resetting socket for session %s\n", aSocket->getSession()->getAuthToken().c_str());
+
+			{
+				WLock l(sessionCs);
+				auto i = sessionSockets.find(aSocket->getSession()->getId());
+				if (i != sessionSockets.end() && i->second == aSocket) {
+					sessionSockets.erase(i);
+				}
+			}
+
 			aSocket->getSession()->onSocketDisconnected();
 			aSocket->setSession(nullptr);
 		}
@@ -224,7 +261,7 @@ namespace webserver {
 		addSocket(hdl, socket);
 	}
 
-	void SocketManager::handleSocketMessage(ConnectionHdl hdl, const std::string& payload) {
+	void SocketManager::handleSocketMessage(ConnectionHdl hdl, std::string_view payload) {
 		auto socket = getSocket(hdl);
 		if (!socket) {
 			dcassert(0);
@@ -29,6 +29,8 @@
 
 #include <airdcpp/core/Speaker.h>
 
+#include <array>
+
 
 namespace webserver {
 	class WebServerManager;
@@ -63,17 +65,32 @@ namespace webserver {
 		void handlePongReceived(ConnectionHdl hdl, const string& aPayload);
 		void handlePongTimeout(ConnectionHdl hdl, const string& aPayload);
 
-		void handleSocketMessage(ConnectionHdl hdl, const std::string& payload);
+		void handleSocketMessage(ConnectionHdl hdl, std::string_view payload);
 
 		void addSocket(ConnectionHdl hdl, const WebSocketPtr& aSocket) noexcept;
 		WebSocketPtr getSocket(ConnectionHdl hdl) const noexcept;
 
 		void pingTimer() noexcept;
 
-		mutable SharedMutex cs;
-
 		using WebSocketList = vector<WebSocketPtr>;
-		std::map<ConnectionHdl, WebSocketPtr, std::owner_less<ConnectionHdl>> sockets;
+
+		// Returns a copy of the current sockets so that they can be accessed without holding the locks
+		WebSocketList getSockets() const noexcept;
+		bool hasSockets() const noexcept;
+
+		// Sockets are split into shards by the connection handle so that connecting/disconnecting sockets don't contend for the same lock
+		static constexpr size_t SOCKET_SHARD_COUNT = 16;
+		struct SocketShard {
+			mutable SharedMutex cs;
+			std::map<ConnectionHdl, WebSocketPtr, std::owner_less<ConnectionHdl>> sockets;
+		};
+
+		static size_t getShardIndex(ConnectionHdl hdl) noexcept;
+		std::array<SocketShard, SOCKET_SHARD_COUNT> shards;
+
+		// Sockets with an authenticated session
+		mutable SharedMutex sessionCs;
+		std::unordered_map<LocalSessionId, WebSocketPtr> sessionSockets;
 
 		TimerPtr socketPingTimer;
 		WebServerManager* wsm;
@@ -20,18 +20,23 @@
 
 #include <web-server/WebServerManager.h>
 
+#include <web-server/ApiMetrics.h>
 #include <web-server/ApiSettingItem.h>
 #include <web-server/ContextMenuManager.h>
+#include <web-server/EventBus.h>
 #include <web-server/ExtensionManager.h>
 #include <web-server/HttpManager.h>
+#include <web-server/RateLimiter.h>
 #include <web-server/SocketManager.h>
 #include <web-server/Timer.h>
 #include <web-server/WebServerSettings.h>
+#include <web-server/WebSocket.h>
 #include <web-server/WebUserManager.h>
 
 #include <airdcpp/core/header/typedefs.h>
 
 #include <airdcpp/core/crypto/CryptoManager.h>
+#include <airdcpp/core/io/File.h>
 #include <airdcpp/events/LogManager.h>
 #include <airdcpp/util/NetworkUtil.h>
 #include <airdcpp/settings/SettingsManager.h>
@@ -43,18 +48,37 @@
 
 #define HANDSHAKE_TIMEOUT 0 // disabled, affects HTTP downloads
 
+#define HTTP_KEEP_ALIVE_TIMEOUT 15 * 1000 // milliseconds
+#define HTTP_KEEP_ALIVE_MAX_REQUESTS 1000
+
+// Per-connection limits for the outgoing WebSocket messages
+#define WS_SEND_QUEUE_MAX_BYTES 32 * 1024 * 1024
+#define WS_SEND_QUEUE_MAX_MESSAGES 50000
+#define WS_SEND_QUEUE_POLICY WsSendQueuePolicy::COALESCE
+
+// Minimum number of threads for running socket requests
+#define MIN_REQUEST_THREADS 8
+
+#define TLS_SESSION_TIMEOUT 60 * 60 // seconds
+#define TLS_SESSION_ID_CONTEXT "airdcpp-web"
+
 namespace webserver {
 	using namespace dcpp;
 	WebServerManager::WebServerManager() : 
 		ios(4),
 		tasks(4),
-		wordGuardTasks(tasks.get_executor())
+		wordGuardTasks(tasks.get_executor()),
+		requests(4),
+		wordGuardRequests(requests.get_executor())
 	{
 		settingsManager = make_unique<WebServerSettings>(this);
 
 		userManager = make_unique<WebUserManager>(this);
 		socketManager = make_unique<SocketManager>(this);
 		httpManager = make_unique<HttpManager>(this);
+		rateLimiter = make_unique<RateLimiter>(*settingsManager);
+		metrics = make_unique<ApiMetrics>();
+		eventBus = make_unique<EventBus>();
 
 		extManager = make_unique<ExtensionManager>(this);
 		contextMenuManager = make_unique<ContextMenuManager>();
@@ -65,6 +89,7 @@ namespace webserver {
 		// Prevent io service from running until we load
 		ios.stop();
 		tasks.stop();
+		requests.stop();
 	}
 
 	WebServerManager::~WebServerManager() {
@@ -74,7 +99,7 @@ namespace webserver {
 	}
 
 	bool WebServerManager::isRunning() const noexcept {
-		return !ios.stopped() || !tasks.stopped();
+		return !ios.stopped() || !tasks.stopped() || !requests.stopped();
 	}
 
 #if defined _MSC_VER && defined _DEBUG
@@ -118,6 +143,12 @@ namespace webserver {
 		aEndpoint.setPongTimeout(WEBCFG(PING_TIMEOUT).num() * 1000);
 
 		aEndpoint.setMaxHttpBodySize(HttpManager::MAX_HTTP_BODY_SIZE);
+		aEndpoint.setMaxHttpUploadSize(HttpManager::MAX_HTTP_UPLOAD_SIZE);
+		aEndpoint.setHttpKeepAlive(HTTP_KEEP_ALIVE_TIMEOUT, HTTP_KEEP_ALIVE_MAX_REQUESTS);
+		// Window bits of 0 disables compression
+		aEndpoint.setWsCompression(WEBCFG(WS_COMPRESSION).boolean() ? WEBCFG(WS_DEFLATE_WINDOW_BITS).num() : 0, WEBCFG(WS_DEFLATE_MEM_LEVEL).num(), static_cast<size_t>(WEBCFG(WS_DEFLATE_MIN_MESSAGE_SIZE).num()));
+		aEndpoint.setWsSendQueueLimits(WS_SEND_QUEUE_MAX_BYTES, WS_SEND_QUEUE_MAX_MESSAGES, WS_SEND_QUEUE_POLICY);
+		aEndpoint.setWsSubprotocols(WebSocket::getSubprotocols());
 	}
 
 	bool WebServerManager::startup(const MessageCallback& errorF, const string& aWebResourcePath, const Callback& aShutdownF) {
@@ -135,6 +166,7 @@ namespace webserver {
 
 		ios.restart();
 		tasks.restart();
+		requests.restart();
 		if (!hasIOContext) {
 			hasIOContext = initialize(errorF);
 		}
@@ -207,6 +239,24 @@ namespace webserver {
 		return endpoint_tls && endpoint_tls->isListening();
 	}
 
+	WsSendQueueStats WebServerManager::getWsSendQueueStats() const noexcept {
+		WsSendQueueStats ret;
+		for (const auto& endpoint: { endpoint_plain.get(), endpoint_tls.get() }) {
+			if (!endpoint) {
+				continue;
+			}
+
+			auto stats = endpoint->getWsSendQueueStats();
+			ret.queuedMessages += stats.queuedMessages;
+			ret.queuedBytes += stats.queuedBytes;
+			ret.coalescedMessages += stats.coalescedMessages;
+			ret.droppedMessages += stats.droppedMessages;
+			ret.disconnectedClients += stats.disconnectedClients;
+		}
+
+		return ret;
+	}
+
 	static bool listenEndpoint(IServerEndpoint& aEndpoint, const ServerConfig& aConfig, const string& aProtocol, const MessageCallback& errorF) noexcept {
 		if (!aConfig.hasValidConfig()) {
 			return false;
@@ -254,6 +304,7 @@ namespace webserver {
 
 		ios_threads = make_unique<boost::thread_group>();
 		task_threads = make_unique<boost::thread_group>();
+		request_threads = make_unique<boost::thread_group>();
 
 		// Start the ASIO io_context run loop running both endpoints
 		for (int x = 0; x < WEBCFG(SERVER_THREADS).num(); ++x) {
@@ -264,6 +315,11 @@ namespace webserver {
 			task_threads->create_thread(boost::bind(&boost::asio::io_context::run, &tasks));
 		}
 
+		// Each request waiting for a hook response reserves a thread
+		for (int x = 0; x < std::max(WEBCFG(SERVER_THREADS).num() * 2, MIN_REQUEST_THREADS); ++x) {
+			request_threads->create_thread(boost::bind(&boost::asio::io_context::run, &requests));
+		}
+
 		// Add timers
 		{
 			const auto logger = getDefaultErrorLogger();
@@ -281,15 +337,69 @@ namespace webserver {
 		return true;
 	}
 
+	bool WebServerManager::isDataLogged() noexcept {
+		if (!hasDataListeners()) {
+			return false;
+		}
+
+		const auto sampleRate = WEBCFG(DATA_LOG_SAMPLE_RATE).num();
+		return sampleRate <= 1 || dataLogCounter++ % sampleRate == 0;
+	}
+
 	void WebServerManager::onData(const string& aData, TransportType aType, Direction aDirection, const string& aIP) noexcept {
+		if (!hasDataListeners()) {
+			return;
+		}
+
 		// Avoid possible deadlocks due to possible simultaneous disconnected/server state listener events
 		addAsyncTask([=, this] {
 			fire(WebServerManagerListener::Data(), aData, aType, aDirection, aIP);
 		});
 	}
 
+	static int selectAlpnProtocol(SSL*, const unsigned char** out_, unsigned char* outLen_, const unsigned char* aIn, unsigned int aInLen, void*) {
+		// Only HTTP/1.1 is supported (WebSocket connections are upgraded from it as well)
+		static const unsigned char supportedProtocols[] = { 8, 'h', 't', 't', 'p', '/', '1', '.', '1' };
+
+		unsigned char* selected = nullptr;
+		if (SSL_select_next_proto(&selected, outLen_, supportedProtocols, sizeof(supportedProtocols), aIn, aInLen) != OPENSSL_NPN_NEGOTIATED) {
+			return SSL_TLSEXT_ERR_NOACK;
+		}
+
+		*out_ = selected;
+		return SSL_TLSEXT_ERR_OK;
+	}
+
+	void WebServerManager::addDataListener(WebServerManagerListener* aListener) noexcept {
+		Lock l(dataListenerCS);
+		dataListeners.insert(aListener);
+		dataListenerCount = dataListeners.size();
+	}
+
+	void WebServerManager::removeDataListener(WebServerManagerListener* aListener) noexcept {
+		Lock l(dataListenerCS);
+		dataListeners.erase(aListener);
+		dataListenerCount = dataListeners.size();
+	}
+
 	context_ptr WebServerManager::handleInitTls() {
-		//std::cout << "on_tls_init called with hdl: " << hdl.lock().get() << std::endl;
+		const auto customCert = WEBCFG(TLS_CERT_PATH).str();
+		const auto customKey = WEBCFG(TLS_CERT_KEY_PATH).str();
+
+		bool useCustom = !customCert.empty() && !customKey.empty();
+
+		const auto& certPath = useCustom ? customCert : SETTING(TLS_CERTIFICATE_FILE);
+		const auto& keyPath = useCustom ? customKey : SETTING(TLS_PRIVATE_KEY_FILE);
+
+		// The same context is shared by all connections so that the session cache and ticket keys can be used for resuming sessions,
+		// create a new one only when the certificate files have changed
+		const auto certificateId = certPath + "|" + keyPath + "|" + Util::toString(File::getLastModified(certPath)) + "|" + Util::toString(File::getLastModified(keyPath));
+
+		Lock l(tlsContextCS);
+		if (tlsContext && tlsContextCertificateId == certificateId) {
+			return tlsContext;
+		}
+
 		auto ctx = make_shared<boost::asio::ssl::context>(boost::asio::ssl::context::tls);
 
 		try {
@@ -302,18 +412,25 @@ namespace webserver {
 				boost::asio::ssl::context::no_compression
 			);
 
-			const auto customCert = WEBCFG(TLS_CERT_PATH).str();
-			const auto customKey = WEBCFG(TLS_CERT_KEY_PATH).str();
-
-			bool useCustom = !customCert.empty() && !customKey.empty();
-
-			ctx->use_certificate_file(useCustom ? customCert : SETTING(TLS_CERTIFICATE_FILE), boost::asio::ssl::context::pem);
-			ctx->use_private_key_file(useCustom ? customKey : SETTING(TLS_PRIVATE_KEY_FILE), boost::asio::ssl::context::pem);
+			ctx->use_certificate_file(certPath, boost::asio::ssl::context::pem);
+			ctx->use_private_key_file(keyPath, boost::asio::ssl::context::pem);
 		} catch (const boost::system::system_error& e) {
 			dcdebug("TLS init failed: %s", e.what());
 		}
 
 		CryptoManager::setContextOptions(ctx->native_handle(), true);
+
+		// Session resumption (both the server-side cache and stateless tickets)
+		auto sslCtx = ctx->native_handle();
+		SSL_CTX_set_session_cache_mode(sslCtx, SSL_SESS_CACHE_SERVER);
+		SSL_CTX_set_timeout(sslCtx, TLS_SESSION_TIMEOUT);
+		SSL_CTX_set_session_id_context(sslCtx, reinterpret_cast<const unsigned char*>(TLS_SESSION_ID_CONTEXT), sizeof(TLS_SESSION_ID_CONTEXT) - 1);
+		SSL_CTX_clear_options(sslCtx, SSL_OP_NO_TICKET);
+
+		SSL_CTX_set_alpn_select_cb(sslCtx, selectAlpnProtocol, nullptr);
+
+		tlsContext = ctx;
+		tlsContextCertificateId = certificateId;
 		return ctx;
 	}
 
@@ -333,6 +450,10 @@ namespace webserver {
 
 		ios.stop();
 		tasks.stop();
+		requests.stop();
+
+		if (request_threads)
+			request_threads->join_all();
 
 		if (task_threads)
 			task_threads->join_all();
@@ -340,6 +461,7 @@ namespace webserver {
 		if (ios_threads)
 			ios_threads->join_all();
 
+		request_threads.reset();
 		task_threads.reset();
 		ios_threads.reset();
 
@@ -354,6 +476,22 @@ namespace webserver {
 		boost::asio::post(tasks, std::move(aCallback));
 	}
 
+	WebServerManager::RequestStrand WebServerManager::createRequestStrand() noexcept {
+		return boost::asio::make_strand(requests);
+	}
+
+	void WebServerManager::addDelayedRequestTask(const RequestStrand& aStrand, Callback&& aCallback, time_t aDelayMillis) noexcept {
+		// The completion handler is run in the strand
+		auto timer = make_shared<boost::asio::steady_timer>(aStrand, std::chrono::milliseconds(aDelayMillis));
+		timer->async_wait([timer, cb = std::move(aCallback)](const boost::system::error_code& aError) {
+			if (aError) {
+				return;
+			}
+
+			cb();
+		});
+	}
+
 	void WebServerManager::log(const string& aMsg, LogMessage::Severity aSeverity) const noexcept {
 		if (!LogManager::getInstance()) {
 			// Core is not initialized yet
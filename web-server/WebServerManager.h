@@ -28,8 +28,11 @@
 #include <airdcpp/message/Message.h>
 #include <airdcpp/core/Singleton.h>
 #include <airdcpp/core/Speaker.h>
+#include <airdcpp/core/thread/CriticalSection.h>
 
+#include <atomic>
 #include <iostream>
+#include <boost/asio/strand.hpp>
 #include <boost/thread/thread.hpp>
 
 
@@ -42,6 +45,9 @@ namespace webserver {
 	class WebUserManager;
 	class SocketManager;
 	class HttpManager;
+	class RateLimiter;
+	class ApiMetrics;
+	class EventBus;
 
 	struct ServerConfig {
 		ServerConfig(ServerSettingItem& aPort, ServerSettingItem& aBindAddress) : port(aPort), bindAddress(aBindAddress) {
@@ -66,6 +72,15 @@ namespace webserver {
 		// Run a task in the task thread pool
 		void addAsyncTask(Callback&& aCallback) noexcept;
 
+		using RequestStrand = boost::asio::strand<boost::asio::io_context::executor_type>;
+
+		// Tasks posted to the same strand are run in the request thread pool one at a time in the order they were added
+		RequestStrand createRequestStrand() noexcept;
+
+		// Post a task to the request strand after the specified delay
+		// The task won't be run if the server is stopped before that
+		void addDelayedRequestTask(const RequestStrand& aStrand, Callback&& aCallback, time_t aDelayMillis) noexcept;
+
 		WebServerManager();
 		~WebServerManager() override;
 
@@ -103,6 +118,18 @@ namespace webserver {
 			return *httpManager.get();
 		}
 
+		RateLimiter& getRateLimiter() noexcept {
+			return *rateLimiter.get();
+		}
+
+		ApiMetrics& getMetrics() noexcept {
+			return *metrics.get();
+		}
+
+		EventBus& getEventBus() noexcept {
+			return *eventBus.get();
+		}
+
 		bool hasValidServerConfig() const noexcept;
 		bool hasUsers() const noexcept;
 		bool waitExtensionsLoaded() const noexcept;
@@ -120,6 +147,9 @@ namespace webserver {
 		bool isListeningPlain() const noexcept;
 		bool isListeningTls() const noexcept;
 
+		// Combined outgoing WebSocket queue statistics of both endpoints
+		WsSendQueueStats getWsSendQueueStats() const noexcept;
+
 		static boost::asio::ip::tcp getDefaultListenProtocol() noexcept;
 
 		// Get the function for shutting down the application
@@ -138,8 +168,22 @@ namespace webserver {
 		static bool isAnyAddress(const string& aAddress) noexcept;
 
 		// For command debugging
+		// Callers should check isDataLogged before constructing the data
 		void onData(const string& aData, TransportType aType, Direction aDirection, const string& aIP) noexcept;
 
+		// Returns whether the next exchange should be passed to onData (there are data listeners and the exchange is included in the sample)
+		// Call this once per request and use the result for logging both the request and its response
+		bool isDataLogged() noexcept;
+
+		// Listeners handling the Data event must register themselves as data listeners as well (in addition to addListener)
+		// The data isn't copied for logging when there is no one to receive it
+		void addDataListener(WebServerManagerListener* aListener) noexcept;
+		void removeDataListener(WebServerManagerListener* aListener) noexcept;
+
+		bool hasDataListeners() const noexcept {
+			return dataListenerCount > 0;
+		}
+
 		WebServerManager(WebServerManager&) = delete;
 		WebServerManager& operator=(WebServerManager&) = delete;
 
@@ -156,6 +200,16 @@ namespace webserver {
 
 		mutable SharedMutex cs;
 
+		CriticalSection dataListenerCS;
+		std::set<WebServerManagerListener*> dataListeners;
+		std::atomic<size_t> dataListenerCount { 0 };
+		std::atomic<uint64_t> dataLogCounter { 0 };
+
+		// Shared by all TLS connections (recreated when the certificate files change)
+		CriticalSection tlsContextCS;
+		context_ptr tlsContext;
+		string tlsContextCertificateId;
+
 		// set up an external io_context to run both endpoints on. This is not
 		// strictly necessary, but simplifies thread management a bit.
 		boost::asio::io_context ios;
@@ -164,12 +218,18 @@ namespace webserver {
 		boost::asio::io_context tasks;
 		boost::asio::executor_work_guard<decltype(tasks.get_executor())> wordGuardTasks;
 
+		boost::asio::io_context requests;
+		boost::asio::executor_work_guard<decltype(requests.get_executor())> wordGuardRequests;
+
 		unique_ptr<WebUserManager> userManager;
 		unique_ptr<ExtensionManager> extManager;
 		unique_ptr<ContextMenuManager> contextMenuManager;
 		unique_ptr<WebServerSettings> settingsManager;
 		unique_ptr<SocketManager> socketManager;
 		unique_ptr<HttpManager> httpManager;
+		unique_ptr<RateLimiter> rateLimiter;
+		unique_ptr<ApiMetrics> metrics;
+		unique_ptr<EventBus> eventBus;
 
 		TimerPtr minuteTimer;
 
@@ -187,6 +247,11 @@ namespace webserver {
 		// all task threads are waiting for a hook response (and there are no threads left to handle those)
 		unique_ptr<boost::thread_group> task_threads;
 
+		// Request threads (API requests of authenticated sockets)
+		// Requests may block while waiting for hook responses so they must not be run in the web server or task threads 
+		// (hook responses are handled directly in the web server threads)
+		unique_ptr<boost::thread_group> request_threads;
+
 		Callback shutdownF;
 	};
 }
@@ -54,6 +54,7 @@ namespace webserver {
 		virtual void on(LoadSettings, const MessageCallback&) noexcept { }
 		virtual void on(SaveSettings, const MessageCallback&) noexcept { }
 
+		// Fired only when data listeners have been registered with WebServerManager::addDataListener
 		virtual void on(Data, const string& /*aData*/, TransportType, Direction, const string& /*aIP*/) noexcept { }
 	};
 
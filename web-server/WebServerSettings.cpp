@@ -31,6 +31,9 @@ namespace webserver {
 #define CONFIG_DIR AppUtil::PATH_USER_CONFIG
 #define CONFIG_VERSION 1
 
+#define RATE_LIMIT_REQUESTS_HELP "Short bursts of up to a few seconds' worth of requests are allowed. Bulk requests are the ones that list or search for large amounts of data"
+#define MODULE_WARMUP_HELP "The modules are created when the session is authenticated so that the first requests won't have to wait for them"
+
 #ifdef _WIN32
 	const string WebServerSettings::localNodeDirectoryName = "Node.js";
 #endif
@@ -53,6 +56,14 @@ namespace webserver {
 		};
 	}
 
+	json WebServerSettings::getDefaultWebUIModuleWarmup() noexcept {
+		// Modules that the Web UI uses right after logging in
+		return {
+			"system", "sessions", "events", "settings", "menus", "hubs", "private_chat",
+			"filelists", "view_files", "transfers", "queue", "share",
+		};
+	}
+
 	WebServerSettings::WebServerSettings(WebServerManager* aServer) :
 		wsm(aServer),
 		settings({
@@ -68,10 +79,28 @@ namespace webserver {
 			{ "web_server_threads",			ResourceManager::WEB_CFG_SERVER_THREADS,	4,								ApiSettingItem::TYPE_NUMBER,	false, { 1, 100 } },
 			{ "extension_engines",			ResourceManager::WEB_CFG_EXTENSION_ENGINES,	getDefaultExtensionEngines(),	ApiSettingItem::TYPE_LIST,		false, {}, ResourceManager::LAST, ApiSettingItem::TYPE_STRUCT, extensionEngines },
 
+			// Event messages contain mostly repetitive property keys so even a small window compresses them well
+			{ "web_socket_compression",				"Compress WebSocket messages",				true,	ApiSettingItem::TYPE_BOOLEAN,	false },
+			{ "web_socket_deflate_window_bits",		"WebSocket compression window bits",		13,		ApiSettingItem::TYPE_NUMBER,	false, { 9, 15 } },
+			{ "web_socket_deflate_memory_level",	"WebSocket compression memory level",		6,		ApiSettingItem::TYPE_NUMBER,	false, { 1, 9 } },
+			{ "web_socket_deflate_min_message_size", "Minimum size of compressed WebSocket messages (bytes)",	256,	ApiSettingItem::TYPE_NUMBER,	false, { 0, MAX_INT_VALUE }, "Smaller messages are sent uncompressed" },
+
+			{ "data_log_sample_rate",		"Log every Nth API request",		1,		ApiSettingItem::TYPE_NUMBER,	false, { 1, MAX_INT_VALUE }, "Applies to the data passed to command debug listeners. Set to 1 to log all requests" },
+
 			{ "default_idle_timeout",		ResourceManager::WEB_CFG_IDLE_TIMEOUT,				20,		ApiSettingItem::TYPE_NUMBER,	false, { 0, MAX_INT_VALUE, ResourceManager::MINUTES_LOWER }, },
 			{ "ping_interval",				ResourceManager::WEB_CFG_PING_INTERVAL,				30,		ApiSettingItem::TYPE_NUMBER,	false, { 1, 10000, ResourceManager::SECONDS_LOWER },		 },
 			{ "ping_timeout",				ResourceManager::WEB_CFG_PING_TIMEOUT,				10,		ApiSettingItem::TYPE_NUMBER,	false, { 1, 10000, ResourceManager::SECONDS_LOWER },		 },
 
+			{ "web_ui_module_warmup",		"API modules to initialize for Web UI sessions",	getDefaultWebUIModuleWarmup(),	ApiSettingItem::TYPE_LIST,	true, {}, MODULE_WARMUP_HELP, ApiSettingItem::TYPE_STRING },
+			{ "extension_module_warmup",	"API modules to initialize for extension sessions",	json::array({ "events", "settings", "menus" }),	ApiSettingItem::TYPE_LIST,	true, {}, MODULE_WARMUP_HELP, ApiSettingItem::TYPE_STRING },
+
+			{ "rate_limit_enabled",					"Limit the API request rate of sessions and users",	false,	ApiSettingItem::TYPE_BOOLEAN,	false },
+			{ "rate_limit_session_requests",		"Requests per second (session)",					50,		ApiSettingItem::TYPE_NUMBER,	false, { 1, 100000 }, RATE_LIMIT_REQUESTS_HELP },
+			{ "rate_limit_session_bulk_requests",	"Bulk requests per second (session)",				10,		ApiSettingItem::TYPE_NUMBER,	false, { 1, 100000 }, RATE_LIMIT_REQUESTS_HELP },
+			{ "rate_limit_user_requests",			"Requests per second (user)",						100,	ApiSettingItem::TYPE_NUMBER,	false, { 1, 100000 }, RATE_LIMIT_REQUESTS_HELP },
+			{ "rate_limit_user_bulk_requests",		"Bulk requests per second (user)",					20,		ApiSettingItem::TYPE_NUMBER,	false, { 1, 100000 }, RATE_LIMIT_REQUESTS_HELP },
+			{ "rate_limit_max_queue_time",			"Maximum queue time for throttled requests",		2,		ApiSettingItem::TYPE_NUMBER,	false, { 0, 60, ResourceManager::SECONDS_LOWER } },
+
 			{ "extensions_debug_mode",		ResourceManager::WEB_CFG_EXTENSIONS_DEBUG_MODE,		false,	ApiSettingItem::TYPE_BOOLEAN,	false },
 			{ "extensions_init_timeout",	ResourceManager::WEB_CFG_EXTENSIONS_INIT_TIMEOUT,	5,		ApiSettingItem::TYPE_NUMBER,	false, { 1, 60, ResourceManager::SECONDS_LOWER } },
 			{ "extensions_auto_update",		ResourceManager::WEB_CFG_EXTENSIONS_AUTO_UPDATE,	true,	ApiSettingItem::TYPE_BOOLEAN,	false },
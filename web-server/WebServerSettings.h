@@ -49,10 +49,27 @@ namespace webserver {
 			SERVER_THREADS,
 			EXTENSION_ENGINES,
 
+			WS_COMPRESSION,
+			WS_DEFLATE_WINDOW_BITS,
+			WS_DEFLATE_MEM_LEVEL,
+			WS_DEFLATE_MIN_MESSAGE_SIZE,
+
+			DATA_LOG_SAMPLE_RATE,
+
 			DEFAULT_SESSION_IDLE_TIMEOUT,
 			PING_INTERVAL,
 			PING_TIMEOUT,
 
+			WEB_UI_MODULE_WARMUP,
+			EXTENSION_MODULE_WARMUP,
+
+			RATE_LIMIT_ENABLED,
+			RATE_LIMIT_SESSION_REQUESTS,
+			RATE_LIMIT_SESSION_BULK_REQUESTS,
+			RATE_LIMIT_USER_REQUESTS,
+			RATE_LIMIT_USER_BULK_REQUESTS,
+			RATE_LIMIT_MAX_QUEUE_TIME,
+
 			EXTENSIONS_DEBUG_MODE,
 			EXTENSIONS_INIT_TIMEOUT,
 			EXTENSIONS_AUTO_UPDATE,
@@ -113,6 +130,7 @@ namespace webserver {
 		ServerSettingItem::List extensionEngines;
 
 		static json getDefaultExtensionEngines() noexcept;
+		static json getDefaultWebUIModuleWarmup() noexcept;
 
 		bool isDirty = false;
 
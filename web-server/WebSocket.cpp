@@ -20,6 +20,7 @@
 
 #include <web-server/WebSocket.h>
 
+#include <web-server/ApiMetrics.h>
 #include <web-server/ApiRouter.h>
 #include <web-server/HttpUtil.h>
 #include <web-server/JsonUtil.h>
@@ -27,11 +28,266 @@
 #include <web-server/WebServerManager.h>
 
 #include <airdcpp/core/header/format.h>
+#include <airdcpp/core/thread/CriticalSection.h>
 #include <airdcpp/core/timer/TimerManager.h>
 #include <airdcpp/util/Util.h>
 
+#include <limits>
+#include <utility>
+
+#define MAX_BATCH_REQUESTS 250
+
+#define SUBPROTOCOL_MSGPACK "airdcpp.msgpack"
+#define SUBPROTOCOL_CBOR "airdcpp.cbor"
 
 namespace webserver {
+	struct WebSocket::BatchRequest {
+		BatchRequest(int aCallbackId, size_t aCount, bool aStream, bool aLogData) : callbackId(aCallbackId), stream(aStream), logData(aLogData), items(aCount), remaining(aCount) {
+			if (!stream) {
+				results = json::array();
+				for (size_t i = 0; i < aCount; i++) {
+					results.push_back(nullptr);
+				}
+			}
+		}
+
+		struct Item {
+			string method;
+			string path;
+			json data;
+			bool valid = false;
+
+			// Set by the handler thread and the completion function of sequential sub-requests
+			std::atomic<bool> sequentialHandoff = false;
+		};
+
+		const int callbackId;
+		const bool stream;
+		const bool logData;
+
+		// Parsed sub-requests (each item is accessed only by the thread running it)
+		vector<Item> items;
+
+		CriticalSection cs;
+		size_t remaining;
+
+		// Combined responses only
+		json results;
+	};
+
+	// SAX handler for incoming requests
+	// Envelope fields are read directly from the parser events and only the request data is built into a json value
+	struct WebSocket::RequestParser {
+		enum Field {
+			FIELD_NONE,
+			FIELD_CALLBACK_ID,
+			FIELD_METHOD,
+			FIELD_PATH,
+			FIELD_DATA,
+			FIELD_OTHER
+		};
+
+		int callbackId = -1;
+		std::string method;
+		std::string path;
+		json data;
+
+		// Returns false for batch requests (parsing is stopped, the message should be parsed as a whole)
+		// Throws json::exception on parse errors and std::invalid_argument for invalid envelope fields
+		bool parse(std::string_view aMessage, MessageFormat aFormat) {
+			const auto inputFormat = aFormat == MessageFormat::FORMAT_MSGPACK ? json::input_format_t::msgpack :
+				aFormat == MessageFormat::FORMAT_CBOR ? json::input_format_t::cbor : json::input_format_t::json;
+
+			if (!json::sax_parse(aMessage.begin(), aMessage.end(), this, inputFormat)) {
+				dcassert(isBatch);
+				return false;
+			}
+
+			if (method.empty()) {
+				throw std::invalid_argument("Field \"method\" is missing");
+			}
+
+			if (path.empty()) {
+				throw std::invalid_argument("Field \"path\" is missing");
+			}
+
+			return true;
+		}
+
+		// SAX interface
+		bool null() {
+			if (field == FIELD_CALLBACK_ID) {
+				field = FIELD_NONE;
+				return true;
+			}
+
+			return onValue(nullptr);
+		}
+
+		bool boolean(bool aValue) {
+			return onValue(aValue);
+		}
+
+		bool number_integer(json::number_integer_t aValue) {
+			return field == FIELD_CALLBACK_ID ? onCallbackId(aValue) : onValue(aValue);
+		}
+
+		bool number_unsigned(json::number_unsigned_t aValue) {
+			return field == FIELD_CALLBACK_ID ? onCallbackId(aValue) : onValue(aValue);
+		}
+
+		bool number_float(json::number_float_t aValue, const json::string_t&) {
+			return field == FIELD_CALLBACK_ID ? onCallbackId(aValue) : onValue(aValue);
+		}
+
+		bool string(json::string_t& aValue) {
+			if (field == FIELD_METHOD || field == FIELD_PATH) {
+				(field == FIELD_METHOD ? method : path) = std::move(aValue);
+				field = FIELD_NONE;
+				return true;
+			}
+
+			return onValue(std::move(aValue));
+		}
+
+		bool binary(json::binary_t& aValue) {
+			return onValue(std::move(aValue));
+		}
+
+		bool start_object(std::size_t) {
+			switch (field) {
+				case FIELD_NONE: return true; // The request
+				case FIELD_DATA: dataStack.push_back(addDataValue(json::object())); return true;
+				case FIELD_OTHER: skipDepth++; return true;
+				default: throwInvalidType();
+			}
+		}
+
+		bool end_object() {
+			return field == FIELD_NONE || onContainerEnd();
+		}
+
+		bool start_array(std::size_t) {
+			switch (field) {
+				case FIELD_NONE: throwNotObject();
+				case FIELD_DATA: dataStack.push_back(addDataValue(json::array())); return true;
+				case FIELD_OTHER: skipDepth++; return true;
+				default: throwInvalidType();
+			}
+		}
+
+		bool end_array() {
+			return onContainerEnd();
+		}
+
+		bool key(json::string_t& aKey) {
+			if (field == FIELD_DATA) {
+				dataKey = std::move(aKey);
+				return true;
+			} else if (field == FIELD_OTHER) {
+				return true;
+			}
+
+			if (aKey == "requests") {
+				isBatch = true;
+				return false;
+			}
+
+			field = aKey == "callback_id" ? FIELD_CALLBACK_ID :
+				aKey == "method" ? FIELD_METHOD :
+				aKey == "path" ? FIELD_PATH :
+				aKey == "data" ? FIELD_DATA : FIELD_OTHER;
+			return true;
+		}
+
+		bool parse_error(std::size_t, const std::string&, const json::exception& aException) {
+			throw aException;
+		}
+	private:
+		template<class T>
+		bool onCallbackId(T aValue) {
+			if constexpr (std::is_floating_point_v<T>) {
+				// NaN fails both comparisons as well
+				if (!(aValue >= static_cast<T>(std::numeric_limits<int>::min()) && aValue < -static_cast<T>(std::numeric_limits<int>::min()))) {
+					throwInvalidType();
+				}
+			} else if (!std::in_range<int>(aValue)) {
+				throwInvalidType();
+			}
+
+			callbackId = static_cast<int>(aValue);
+			field = FIELD_NONE;
+			return true;
+		}
+
+		bool onValue(json&& aValue) {
+			switch (field) {
+				case FIELD_NONE: throwNotObject();
+				case FIELD_DATA: addDataValue(std::move(aValue)); break;
+				case FIELD_OTHER: break;
+				default: throwInvalidType();
+			}
+
+			if (dataStack.empty() && skipDepth == 0) {
+				field = FIELD_NONE;
+			}
+
+			return true;
+		}
+
+		bool onContainerEnd() {
+			if (field == FIELD_DATA) {
+				dataStack.pop_back();
+			} else {
+				dcassert(field == FIELD_OTHER && skipDepth > 0);
+				skipDepth--;
+			}
+
+			if (dataStack.empty() && skipDepth == 0) {
+				field = FIELD_NONE;
+			}
+
+			return true;
+		}
+
+		// Returns a pointer to the added value (it stays valid while child values are being added)
+		json* addDataValue(json&& aValue) {
+			if (dataStack.empty()) {
+				data = std::move(aValue);
+				return &data;
+			}
+
+			auto& parent = *dataStack.back();
+			if (parent.is_array()) {
+				parent.push_back(std::move(aValue));
+				return &parent.back();
+			}
+
+			auto& value = parent[dataKey];
+			value = std::move(aValue);
+			return &value;
+		}
+
+		[[noreturn]] static void throwNotObject() {
+			throw std::invalid_argument("Request must be an object");
+		}
+
+		[[noreturn]] void throwInvalidType() const {
+			throw std::invalid_argument(field == FIELD_CALLBACK_ID ? "Field \"callback_id\" must be a number" :
+				field == FIELD_METHOD ? "Field \"method\" must be a string" : "Field \"path\" must be a string");
+		}
+
+		Field field = FIELD_NONE;
+		bool isBatch = false;
+
+		// Containers of the request data that are being parsed
+		std::vector<json*> dataStack;
+		json::string_t dataKey;
+
+		// Nesting level of unknown fields
+		int skipDepth = 0;
+	};
+
 	WebSocket::WebSocket(bool aIsSecure, ConnectionHdl aHdl, IServerEndpoint& aEndpoint, WebServerManager* aWsm) :
 		hdl(aHdl), endpoint(aEndpoint), wsm(aWsm), secure(aIsSecure), timeCreated(GET_TICK())
 	{
@@ -45,13 +301,21 @@ namespace webserver {
 		if (!url.empty() && url.back() != '/') {
 			url += '/';
 		}
+
+		// Binary message format
+		const auto subprotocol = endpoint.getWsSubprotocol(hdl);
+		if (subprotocol == SUBPROTOCOL_MSGPACK) {
+			format = MessageFormat::FORMAT_MSGPACK;
+		} else if (subprotocol == SUBPROTOCOL_CBOR) {
+			format = MessageFormat::FORMAT_CBOR;
+		}
 	}
 
 	WebSocket::~WebSocket() {
 		dcdebug("Websocket was deleted\n");
 	}
 
-	void WebSocket::sendApiResponse(const json& aResponseJson, const json& aErrorJson, http::status aCode, int aCallbackId) noexcept {
+	void WebSocket::sendApiResponse(const json& aResponseJson, const json& aErrorJson, http::status aCode, int aCallbackId, bool aLogData, int aBatchIndex) noexcept {
 		json j;
 
 		if (aCallbackId > 0) {
@@ -60,6 +324,10 @@ namespace webserver {
 			// Failed to parse the request
 			dcassert(!aErrorJson.is_null());
 		}
+
+		if (aBatchIndex >= 0) {
+			j["batch_index"] = aBatchIndex;
+		}
 		
 		j["code"] = aCode;
 
@@ -73,7 +341,7 @@ namespace webserver {
 		}
 
 		try {
-			sendPlain(j);
+			sendJson(j, WsMessageInfo(), aLogData);
 		} catch (const json::exception& e) {
 			sendApiResponse(
 				nullptr, 
@@ -81,11 +349,30 @@ namespace webserver {
 					{ "message", "Failed to convert data to JSON: " + string(e.what()) }
 				}, 
 				http::status::internal_server_error, 
-				aCallbackId
+				aCallbackId,
+				aLogData,
+				aBatchIndex
 			);
 		}
 	}
 
+	void WebSocket::sendApiResponseRaw(const string& aJsonResponse, http::status aCode, int aCallbackId, bool aLogData) noexcept {
+		dcassert(aCallbackId > 0 && HttpUtil::isStatusOk(aCode));
+
+		// Same format as with sendApiResponse (keys in alphabetical order)
+		string str;
+		str.reserve(aJsonResponse.size() + 48);
+		str += "{\"callback_id\":";
+		str += Util::toString(aCallbackId);
+		str += ",\"code\":";
+		str += Util::toString(static_cast<int>(aCode));
+		str += ",\"data\":";
+		str += aJsonResponse;
+		str += "}";
+
+		sendSerialized(std::move(str), WsMessageInfo(), aLogData);
+	}
+
 	void WebSocket::logError(const string& aMessage) const noexcept {
 		auto message = (dcpp_fmt("Websocket: " + aMessage + " (%s)") % (session ? session->getAuthToken().c_str() : "no session")).str();
 		// In phase 2 without websocketpp logging, just print to debug output
@@ -96,19 +383,108 @@ namespace webserver {
 		dcdebug(string(aMessage + " (%s)\n").c_str(), session ? session->getAuthToken().c_str() : "no session");
 	}
 
-	void WebSocket::sendPlain(const json& aJson) {
+	StringList WebSocket::getSubprotocols() noexcept {
+		return { SUBPROTOCOL_MSGPACK, SUBPROTOCOL_CBOR };
+	}
+
+	string WebSocket::encode(const json& aJson, MessageFormat aFormat) {
+		string ret;
+		switch (aFormat) {
+			case MessageFormat::FORMAT_MSGPACK: json::to_msgpack(aJson, ret); break;
+			case MessageFormat::FORMAT_CBOR: json::to_cbor(aJson, ret); break;
+			default: ret = aJson.dump();
+		}
+
+		return ret;
+	}
+
+	json WebSocket::decode(std::string_view aData, MessageFormat aFormat) {
+		switch (aFormat) {
+			case MessageFormat::FORMAT_MSGPACK: return json::from_msgpack(aData);
+			case MessageFormat::FORMAT_CBOR: return json::from_cbor(aData);
+			default: return json::parse(aData);
+		}
+	}
+
+	string WebSocket::toLogString(std::string_view aData) const noexcept {
+		if (format == MessageFormat::FORMAT_JSON) {
+			return string(aData);
+		}
+
+		try {
+			return decode(aData, format).dump();
+		} catch (const json::exception&) {
+			return "(invalid binary data, " + Util::toString(aData.size()) + " bytes)";
+		}
+	}
+
+	void WebSocket::sendPlain(const json& aJson, const WsMessageInfo& aInfo) {
+		sendJson(aJson, aInfo, wsm->isDataLogged());
+	}
+
+	void WebSocket::sendJson(const json& aJson, const WsMessageInfo& aInfo, bool aLogData) {
 		string str;
 		try {
-			str = aJson.dump();
+			str = encode(aJson, format);
 		} catch (const json::exception& e) {
 			logError("Failed to convert data to JSON: " + string(e.what()));
 			throw;
 		}
 
-		wsm->onData(str, TransportType::TYPE_SOCKET, Direction::OUTGOING, getIp());
+		sendEncoded(std::move(str), aInfo, aLogData);
+	}
 
+	void WebSocket::sendText(string&& aData, const WsMessageInfo& aInfo) noexcept {
+		sendSerialized(std::move(aData), aInfo, wsm->isDataLogged());
+	}
+
+	void WebSocket::sendSerialized(string&& aData, const WsMessageInfo& aInfo, bool aLogData) noexcept {
+		if (format == MessageFormat::FORMAT_JSON) {
+			sendEncoded(std::move(aData), aInfo, aLogData);
+			return;
+		}
+
+		// Fallback, callers should build json messages for sockets using a binary format
+		dcdebug("WebSocket: parsing serialized data for a binary socket\n");
+
+		string str;
 		try {
-			endpoint.wsSendText(hdl, str);
+			str = encode(json::parse(aData), format);
+		} catch (const json::exception& e) {
+			logError("Failed to convert data: " + string(e.what()));
+			return;
+		}
+
+		sendEncoded(std::move(str), aInfo, aLogData);
+	}
+
+	void WebSocket::sendEncoded(string&& aData, const WsMessageInfo& aInfo, bool aLogData) noexcept {
+		wsm->getMetrics().onData(TransportType::TYPE_SOCKET, Direction::OUTGOING, aData.size());
+		if (aLogData) {
+			wsm->onData(toLogString(aData), TransportType::TYPE_SOCKET, Direction::OUTGOING, getIp());
+		}
+
+		auto info = aInfo;
+		info.binary = format != MessageFormat::FORMAT_JSON;
+
+		try {
+			endpoint.wsSendText(hdl, std::move(aData), info);
+		} catch (const std::exception& e) {
+			logError("Failed to send data: " + string(e.what()));
+		}
+	}
+
+	void WebSocket::sendShared(const std::shared_ptr<const string>& aData, const WsMessageInfo& aInfo) noexcept {
+		wsm->getMetrics().onData(TransportType::TYPE_SOCKET, Direction::OUTGOING, aData->size());
+		if (wsm->isDataLogged()) {
+			wsm->onData(toLogString(*aData), TransportType::TYPE_SOCKET, Direction::OUTGOING, getIp());
+		}
+
+		auto info = aInfo;
+		info.binary = format != MessageFormat::FORMAT_JSON;
+
+		try {
+			endpoint.wsSendShared(hdl, aData, info);
 		} catch (const std::exception& e) {
 			logError("Failed to send data: " + string(e.what()));
 		}
@@ -131,64 +507,284 @@ namespace webserver {
 		}
 	}
 
-	void WebSocket::parseRequest(const string& aRequest, int& callbackId_, string& method_, string& path_, json& data_) {
-		const auto requestJson = json::parse(aRequest);
-
-		callbackId_ = JsonUtil::getOptionalFieldDefault<int>("callback_id", requestJson, -1);
-		path_ = requestJson.at("path");
-		data_ = JsonUtil::getOptionalRawField("data", requestJson);
-		method_ = requestJson.at("method");
+	void WebSocket::parseRequest(const json& aRequestJson, string& method_, string& path_, json& data_) {
+		path_ = aRequestJson.at("path");
+		data_ = JsonUtil::getOptionalRawField("data", aRequestJson);
+		method_ = aRequestJson.at("method");
 	}
 
-	void WebSocket::onData(const string& aMessage, const SessionCallback& aAuthCallback) {
+	void WebSocket::onData(std::string_view aMessage, const SessionCallback& aAuthCallback) {
 		// Logging
-		wsm->onData(aMessage, TransportType::TYPE_SOCKET, Direction::INCOMING, getIp());
-		dcdebug("Received socket request: %s\n", Util::truncate(aMessage, 500).c_str());
+		wsm->getMetrics().onData(TransportType::TYPE_SOCKET, Direction::INCOMING, aMessage.size());
+
+		// The response is logged together with the request
+		const auto logData = wsm->isDataLogged();
+		if (logData) {
+			wsm->onData(toLogString(aMessage), TransportType::TYPE_SOCKET, Direction::INCOMING, getIp());
+		}
+
+		dcdebug("Received socket request: %s\n", Util::truncate(toLogString(aMessage), 500).c_str());
 
 		// Parse request
-		int callbackId = -1;
-		string method, path;
-		json data;
+		RequestParser request;
 		try {
-			parseRequest(aMessage, callbackId, method, path, data);
+			if (!request.parse(aMessage, format)) {
+				auto requestJson = decode(aMessage, format);
+				request.callbackId = JsonUtil::getOptionalFieldDefault<int>("callback_id", requestJson, -1);
+				handleBatchRequest(request.callbackId, requestJson, aAuthCallback, logData);
+				return;
+			}
 		} catch (const json::exception& e) {
-			sendApiResponse(nullptr, ApiRequest::toResponseErrorStr("Failed to parse JSON: " + string(e.what())), http::status::bad_request, callbackId);
+			sendApiResponse(nullptr, ApiRequest::toResponseErrorStr("Failed to parse JSON: " + string(e.what())), http::status::bad_request, request.callbackId, logData);
 			return;
 		} catch (const std::invalid_argument& e) {
-			sendApiResponse(nullptr, ApiRequest::toResponseErrorStr(e.what()), http::status::bad_request, callbackId);
+			sendApiResponse(nullptr, ApiRequest::toResponseErrorStr(e.what()), http::status::bad_request, request.callbackId, logData);
 			return;
 		}
 
-		// Prepare response handlers
-		const auto responseF = [callbackId, this](http::status aStatus, const json& aResponseJsonData, const json& aResponseErrorJson) {
-			sendApiResponse(aResponseJsonData, aResponseErrorJson, aStatus, callbackId);
+		const auto callbackId = request.callbackId;
+		auto method = std::move(request.method);
+		auto path = std::move(request.path);
+		auto data = std::move(request.data);
+
+		auto completionF = [callbackId, logData, this](http::status aStatus, const json& aResponseJsonData, const json& aResponseErrorJson) {
+			sendApiResponse(aResponseJsonData, aResponseErrorJson, aStatus, callbackId, logData);
 		};
 
+		// Serialized responses can be sent as such to JSON sockets
+		RawCompletionF rawCompletionF;
+		if (format == MessageFormat::FORMAT_JSON) {
+			rawCompletionF = [callbackId, logData, this](http::status aStatus, const string& aResponseData) {
+				sendApiResponseRaw(aResponseData, aStatus, callbackId, logData);
+			};
+		}
+
+		// Authentication requests are always handled in the socket thread
+		if (hasConcurrentRequests() && !isHookCompletionRequest(method, path)) {
+			auto apiModule = path.substr(0, path.find('/'));
+			queueRequest(apiModule, [self = shared_from_this(), method = std::move(method), path = std::move(path), data = std::move(data), completionF = std::move(completionF), rawCompletionF = std::move(rawCompletionF)]() mutable {
+				self->routeRequest(method, path, std::move(data), nullptr, completionF, rawCompletionF);
+			});
+
+			return;
+		}
+
+		routeRequest(method, path, std::move(data), aAuthCallback, completionF, rawCompletionF);
+	}
+
+	bool WebSocket::isHookCompletionRequest(const string& aMethod, const string& aPath) noexcept {
+		// {module}/hooks/{hook_id}/{completion_id}/resolve|reject
+		if (aMethod != "POST" || aPath.find("/hooks/") == string::npos) {
+			return false;
+		}
+
+		std::string_view action(aPath);
+		action.remove_prefix(action.find_last_of('/') + 1);
+		return action == "resolve" || action == "reject";
+	}
+
+	bool WebSocket::hasConcurrentRequests() const noexcept {
+		auto s = getSession();
+		return s && s->getConcurrentRequests();
+	}
+
+	boost::asio::strand<boost::asio::io_context::executor_type> WebSocket::getRequestStrand(const string& aApiModule) noexcept {
+		Lock l(requestStrandCS);
+		auto i = requestStrands.find(aApiModule);
+		if (i == requestStrands.end()) {
+			i = requestStrands.emplace(aApiModule, wsm->createRequestStrand()).first;
+		}
+
+		// Copies refer to the same strand
+		return i->second;
+	}
+
+	void WebSocket::queueRequest(const string& aApiModule, Callback&& aTask) noexcept {
+		boost::asio::post(getRequestStrand(aApiModule), std::move(aTask));
+	}
+
+	void WebSocket::queueDelayedRequest(const string& aApiModule, Callback&& aTask, time_t aDelayMillis) noexcept {
+		wsm->addDelayedRequestTask(getRequestStrand(aApiModule), std::move(aTask), aDelayMillis);
+	}
+
+	void WebSocket::routeRequest(const string& aMethod, const string& aPath, json&& aData, const SessionCallback& aAuthCallback, const ApiCompletionF& aCompletionF, const RawCompletionF& aRawCompletionF) noexcept {
 		bool isDeferred = false;
-		const auto deferredF = [&isDeferred, &responseF]() {
+		const auto deferredF = [&isDeferred, &aCompletionF]() {
 			isDeferred = true;
-
-			return [responseF](http::status aStatus, const json& aResponseJsonData, const json& aResponseErrorJson) {
-				responseF(aStatus, aResponseJsonData, aResponseErrorJson);
-			};
+			return aCompletionF;
 		};
 
-		// Route request
-
 		http::status code;
 		json responseJsonData, responseErrorJson;
+		string responseRawData;
 		try {
-			ApiRequest apiRequest(url + path, method, std::move(data), getSession(), deferredF, responseJsonData, responseErrorJson);
+			ApiRequest apiRequest(url + aPath, aMethod, std::move(aData), getSession(), deferredF, responseJsonData, responseErrorJson);
+			// Raw responses would have to be parsed for the binary formats
+			if (aRawCompletionF && format == MessageFormat::FORMAT_JSON) {
+				apiRequest.setRawResponseOutput(&responseRawData);
+			}
+
+			// Requests queued by the rate limiter are run in order with the later requests for the same API module
+			apiRequest.setDelayedTaskHandler([self = shared_from_this(), apiModule = aPath.substr(0, aPath.find('/'))](Callback&& aTask, time_t aDelayMillis) {
+				self->queueDelayedRequest(apiModule, std::move(aTask), aDelayMillis);
+			});
+
 			RouterRequest routerRequest{ apiRequest, secure, aAuthCallback, getIp() };
 			code = ApiRouter::handleRequest(routerRequest);
 		} catch (const std::invalid_argument& e) {
-			sendApiResponse(nullptr, ApiRequest::toResponseErrorStr(e.what()), http::status::bad_request, callbackId);
+			aCompletionF(http::status::bad_request, nullptr, ApiRequest::toResponseErrorStr(e.what()));
+			return;
+		}
+
+		if (isDeferred) {
 			return;
 		}
 
-		if (!isDeferred) {
-			responseF(code, responseJsonData, responseErrorJson);
+		if (!responseRawData.empty() && HttpUtil::isStatusOk(code)) {
+			aRawCompletionF(code, responseRawData);
+		} else {
+			aCompletionF(code, responseJsonData, responseErrorJson);
+		}
+	}
+
+	// Batch request format:
+	// { "callback_id": 1, "requests": [ { "method": "GET", "path": "...", "data": ... }, ... ], "parallel": false, "stream": false }
+	//
+	// Combined response: { "callback_id": 1, "code": 200, "data": [ { "code": 200, "data": ... }, { "code": 404, "error": ... }, ... ] }
+	// Streamed responses: { "callback_id": 1, "batch_index": 0, "code": 200, "data": ... } for each sub-request in completion order, 
+	// followed by { "callback_id": 1, "code": 204 } after all sub-requests have completed
+	void WebSocket::handleBatchRequest(int aCallbackId, json& aRequestJson, const SessionCallback& aAuthCallback, bool aLogData) {
+		auto& requests = aRequestJson.at("requests");
+		if (!requests.is_array() || requests.empty()) {
+			throw std::invalid_argument("Field \"requests\" must be a non-empty array");
+		}
+
+		if (requests.size() > MAX_BATCH_REQUESTS) {
+			throw std::invalid_argument("Maximum of " + Util::toString(MAX_BATCH_REQUESTS) + " requests are allowed in a batch");
 		}
 
+		const auto stream = JsonUtil::getOptionalFieldDefault<bool>("stream", aRequestJson, false);
+		const auto parallel = JsonUtil::getOptionalFieldDefault<bool>("parallel", aRequestJson, false);
+
+		auto batch = std::make_shared<BatchRequest>(aCallbackId, requests.size(), stream, aLogData);
+		for (size_t i = 0; i < requests.size(); i++) {
+			auto& item = batch->items[i];
+			try {
+				parseRequest(requests[i], item.method, item.path, item.data);
+				item.valid = true;
+			} catch (const json::exception& e) {
+				onBatchItemCompleted(batch, i, http::status::bad_request, nullptr, ApiRequest::toResponseErrorStr("Failed to parse JSON: " + string(e.what())));
+			}
+		}
+
+		if (!parallel) {
+			routeSequentialBatchItems(batch, 0, aAuthCallback, false);
+			return;
+		}
+
+		// Authentication requests must be handled in order in the socket thread
+		if (!hasConcurrentRequests()) {
+			for (size_t i = 0; i < batch->items.size(); i++) {
+				routeBatchItem(batch, i, aAuthCallback, false);
+			}
+
+			return;
+		}
+
+		for (size_t i = 0; i < batch->items.size(); i++) {
+			queueBatchItem(batch, i);
+		}
+	}
+
+	void WebSocket::queueBatchItem(const BatchRequestPtr& aBatch, size_t aIndex) noexcept {
+		const auto& item = aBatch->items[aIndex];
+		if (!item.valid) {
+			return;
+		}
+
+		if (isHookCompletionRequest(item.method, item.path)) {
+			routeBatchItem(aBatch, aIndex, nullptr, false);
+			return;
+		}
+
+		queueRequest(item.path.substr(0, item.path.find('/')), [self = shared_from_this(), aBatch, aIndex] {
+			self->routeBatchItem(aBatch, aIndex, nullptr, false);
+		});
+	}
+
+	void WebSocket::routeSequentialBatchItems(const BatchRequestPtr& aBatch, size_t aIndex, const SessionCallback& aAuthCallback, bool aQueued) noexcept {
+		for (; aIndex < aBatch->items.size(); aIndex++) {
+			auto& item = aBatch->items[aIndex];
+			if (!item.valid) {
+				continue;
+			}
+
+			// Run the sub-request in the strand of its API module
+			if (!aQueued && hasConcurrentRequests() && !isHookCompletionRequest(item.method, item.path)) {
+				queueRequest(item.path.substr(0, item.path.find('/')), [self = shared_from_this(), aBatch, aIndex] {
+					self->routeSequentialBatchItems(aBatch, aIndex, nullptr, true);
+				});
+
+				return;
+			}
+
+			aQueued = false;
+			routeBatchItem(aBatch, aIndex, aAuthCallback, true);
+
+			// Whichever finishes last (the handler or the completion function) continues with the next sub-request
+			if (!item.sequentialHandoff.exchange(true)) {
+				// Deferred, the next sub-request is started by the completion function
+				return;
+			}
+		}
+	}
+
+	void WebSocket::routeBatchItem(const BatchRequestPtr& aBatch, size_t aIndex, const SessionCallback& aAuthCallback, bool aSequential) noexcept {
+		auto& item = aBatch->items[aIndex];
+		if (!item.valid) {
+			return;
+		}
+
+		auto completionF = [aBatch, aIndex, aSequential, self = shared_from_this()](http::status aStatus, const json& aResponseJsonData, const json& aResponseErrorJson) {
+			self->onBatchItemCompleted(aBatch, aIndex, aStatus, aResponseJsonData, aResponseErrorJson);
+
+			// Sequential sub-requests are started only after the previous one has completed
+			if (aSequential && aBatch->items[aIndex].sequentialHandoff.exchange(true)) {
+				self->routeSequentialBatchItems(aBatch, aIndex + 1, nullptr, false);
+			}
+		};
+
+		routeRequest(item.method, item.path, std::move(item.data), aAuthCallback, completionF);
+	}
+
+	void WebSocket::onBatchItemCompleted(const BatchRequestPtr& aBatch, size_t aIndex, http::status aStatus, const json& aResponseJsonData, const json& aResponseErrorJson) noexcept {
+		if (aBatch->stream) {
+			sendApiResponse(aResponseJsonData, aResponseErrorJson, aStatus, aBatch->callbackId, aBatch->logData, static_cast<int>(aIndex));
+		}
+
+		{
+			Lock l(aBatch->cs);
+			if (!aBatch->stream) {
+				auto& result = aBatch->results[aIndex];
+				result["code"] = aStatus;
+				if (!HttpUtil::isStatusOk(aStatus)) {
+					result["error"] = aResponseErrorJson;
+				} else if (!aResponseJsonData.is_null()) {
+					result["data"] = aResponseJsonData;
+				}
+			}
+
+			aBatch->remaining--;
+			if (aBatch->remaining > 0) {
+				return;
+			}
+		}
+
+		// All sub-requests have completed
+		if (aBatch->stream) {
+			sendApiResponse(nullptr, nullptr, http::status::no_content, aBatch->callbackId, aBatch->logData);
+		} else {
+			sendApiResponse(aBatch->results, nullptr, http::status::ok, aBatch->callbackId, aBatch->logData);
+		}
 	}
-}
\ No newline at end of file
+}
@@ -24,13 +24,24 @@
 #include "forward.h"
 #include "IServerEndpoint.h"
 
+#include <airdcpp/core/thread/CriticalSection.h>
 #include <airdcpp/core/types/GetSet.h>
 
+#include <boost/asio/strand.hpp>
+
 namespace webserver {
 	// WebSockets are owned by SocketManager and API modules
 	class WebServerManager;
 
-	class WebSocket {
+	// Message encoding selected with the WebSocket subprotocol (the API semantics are the same with all formats)
+	enum class MessageFormat {
+		FORMAT_JSON, // Text frames (default)
+		FORMAT_MSGPACK,
+		FORMAT_CBOR,
+		FORMAT_LAST
+	};
+
+	class WebSocket : public std::enable_shared_from_this<WebSocket> {
 	public:
 		WebSocket(bool aIsSecure, ConnectionHdl aHdl, IServerEndpoint& aEndpoint, WebServerManager* aWsm);
 		~WebSocket();
@@ -41,10 +52,25 @@ namespace webserver {
 
 		// Send raw data
 		// Throws json::exception on JSON conversion errors
-		void sendPlain(const json& aJson);
-		void sendApiResponse(const json& aJsonResponse, const json& aErrorJson, http::status aCode, int aCallbackId) noexcept;
+		void sendPlain(const json& aJson, const WsMessageInfo& aInfo = WsMessageInfo());
+
+		// Send data that may be shared with other sockets
+		// The data must be encoded with the message format of this socket
+		void sendShared(const std::shared_ptr<const string>& aData, const WsMessageInfo& aInfo) noexcept;
+
+		// Send serialized JSON
+		// The data is parsed and converted for sockets using a binary message format (send json instead when the format isn't FORMAT_JSON)
+		void sendText(string&& aData, const WsMessageInfo& aInfo) noexcept;
+
+		// Responses are logged if the request was logged (aLogData)
+		// Responses for streamed batch requests include the index of the sub-request
+		void sendApiResponse(const json& aJsonResponse, const json& aErrorJson, http::status aCode, int aCallbackId, bool aLogData, int aBatchIndex = -1) noexcept;
+
+		// Send a successful response with data that has been serialized already
+		void sendApiResponseRaw(const string& aJsonResponse, http::status aCode, int aCallbackId, bool aLogData) noexcept;
 
-		void onData(const string& aPayload, const SessionCallback& aAuthCallback);
+		// The payload is only accessed during the call
+		void onData(std::string_view aPayload, const SessionCallback& aAuthCallback);
 
 		WebSocket(WebSocket&) = delete;
 		WebSocket& operator=(WebSocket&) = delete;
@@ -66,9 +92,61 @@ namespace webserver {
 			return url;
 		}
 
-		// Throws json exception (from the json library) in case of invalid JSON, ArgumentException in case of invalid properties
-		static void parseRequest(const string& aRequest, int& callbackId_, string& method_, string& path_, json& data_);
+		MessageFormat getMessageFormat() const noexcept {
+			return format;
+		}
+
+		// Subprotocols that can be requested by the client for using a binary message format
+		static StringList getSubprotocols() noexcept;
+
+		// Throws json::exception on JSON conversion errors
+		static string encode(const json& aJson, MessageFormat aFormat);
+
+		// Throws json::exception on parse errors
+		static json decode(std::string_view aData, MessageFormat aFormat);
+
+		// Throws json exception (from the json library) in case of invalid properties
+		static void parseRequest(const json& aRequestJson, string& method_, string& path_, json& data_);
 	private:
+		struct BatchRequest;
+		struct RequestParser;
+		using BatchRequestPtr = std::shared_ptr<BatchRequest>;
+
+		// The completion function may be called asynchronously for deferred requests
+		// Successful responses serialized by the handler are passed to the raw completion function (if one is provided)
+		using RawCompletionF = std::function<void(http::status, const string&)>;
+		void routeRequest(const string& aMethod, const string& aPath, json&& aData, const SessionCallback& aAuthCallback, const ApiCompletionF& aCompletionF, const RawCompletionF& aRawCompletionF = nullptr) noexcept;
+
+		// Throws json exception in case of invalid properties, std::invalid_argument in case of invalid batch options
+		void handleBatchRequest(int aCallbackId, json& aRequestJson, const SessionCallback& aAuthCallback, bool aLogData);
+		void queueBatchItem(const BatchRequestPtr& aBatch, size_t aIndex) noexcept;
+
+		// Sequential sub-requests are started one at a time after the previous one has completed (including deferred ones)
+		// The authentication callback is used only for the sub-requests that are routed synchronously
+		void routeSequentialBatchItems(const BatchRequestPtr& aBatch, size_t aIndex, const SessionCallback& aAuthCallback, bool aQueued) noexcept;
+		void routeBatchItem(const BatchRequestPtr& aBatch, size_t aIndex, const SessionCallback& aAuthCallback, bool aSequential) noexcept;
+		void onBatchItemCompleted(const BatchRequestPtr& aBatch, size_t aIndex, http::status aStatus, const json& aResponseJsonData, const json& aResponseErrorJson) noexcept;
+
+		// Request strands by API module (created on the first request)
+		CriticalSection requestStrandCS;
+		std::map<string, boost::asio::strand<boost::asio::io_context::executor_type>> requestStrands;
+
+		// Run the request in the request thread pool after earlier requests for the same API module
+		void queueRequest(const string& aApiModule, Callback&& aTask) noexcept;
+
+		// Run the request in the API module strand after the delay (requests queued by the rate limiter)
+		void queueDelayedRequest(const string& aApiModule, Callback&& aTask, time_t aDelayMillis) noexcept;
+
+		boost::asio::strand<boost::asio::io_context::executor_type> getRequestStrand(const string& aApiModule) noexcept;
+
+		// Whether the client has enabled concurrent requests for the session (see Session::getConcurrentRequests)
+		// Requests are otherwise handled in order in the socket thread
+		// Requests for the same API module are still handled in the order they were received (hook responses are handled immediately)
+		bool hasConcurrentRequests() const noexcept;
+
+		// Hook responses can't be queued after the requests that may be waiting for them
+		static bool isHookCompletionRequest(const string& aMethod, const string& aPath) noexcept;
+
 		const ConnectionHdl hdl;
 		IServerEndpoint& endpoint;
 		WebServerManager* wsm;
@@ -76,6 +154,17 @@ namespace webserver {
 		const time_t timeCreated;
 		string url;
 		string ip;
+		MessageFormat format = MessageFormat::FORMAT_JSON;
+
+		// Throws json::exception on JSON conversion errors
+		void sendJson(const json& aJson, const WsMessageInfo& aInfo, bool aLogData);
+		void sendSerialized(string&& aData, const WsMessageInfo& aInfo, bool aLogData) noexcept;
+
+		// Send data encoded with the message format of this socket
+		void sendEncoded(string&& aData, const WsMessageInfo& aInfo, bool aLogData) noexcept;
+
+		// Readable version of the data for logging
+		string toLogString(std::string_view aData) const noexcept;
 	};
 }
 
@@ -56,20 +56,35 @@ namespace webserver {
 		wsm->removeListener(this);
 	}
 
-	SessionPtr WebUserManager::parseHttpSession(const string& aAuthToken, const string& aIP) {
-		auto token = aAuthToken;
-
-		auto authType = AuthType::UNKNOWN;
-		if (token.starts_with("Basic ")) {
-			token = Util::base64_decode(token.substr(6));
-			authType = AuthType::BASIC;
-		} else if (token.starts_with("Bearer ")) {
-			token = token.substr(7);
-			authType = AuthType::BEARER;
+	WebUserManager::AuthType WebUserManager::decodeHttpAuthToken(const string& aAuthToken, string& token_) noexcept {
+		if (aAuthToken.starts_with("Basic ")) {
+			token_ = Util::base64_decode(aAuthToken.substr(6));
+			return AuthType::BASIC;
+		}
+
+		if (aAuthToken.starts_with("Bearer ")) {
+			token_ = aAuthToken.substr(7);
 		} else {
-			authType = AuthType::BEARER;
+			token_ = aAuthToken;
+		}
+
+		return AuthType::BEARER;
+	}
+
+	SessionPtr WebUserManager::getExistingHttpSession(const string& aAuthToken) const noexcept {
+		string token;
+		if (decodeHttpAuthToken(aAuthToken, token) != AuthType::BEARER) {
+			// Basic auth sessions are keyed by the credentials
+			return nullptr;
 		}
 
+		return getSession(token);
+	}
+
+	SessionPtr WebUserManager::parseHttpSession(const string& aAuthToken, const string& aIP) {
+		string token;
+		const auto authType = decodeHttpAuthToken(aAuthToken, token);
+
 		auto session = getSession(token);
 		if (!session) {
 			if (authType == AuthType::BASIC) {
@@ -162,9 +177,51 @@ namespace webserver {
 		}
 
 		fire(WebUserManagerListener::SessionCreated(), session);
+
+		warmUpModules(session);
 		return session;
 	}
 
+	void WebUserManager::warmUpModules(const SessionPtr& aSession) noexcept {
+		auto modules = getModuleWarmupProfile(aSession->getSessionType());
+		if (modules.empty()) {
+			return;
+		}
+
+		wsm->addAsyncTask([weakSession = std::weak_ptr<Session>(aSession), modules = std::move(modules)] {
+			// The session may have been removed already
+			auto session = weakSession.lock();
+			if (session) {
+				session->initModules(modules);
+			}
+		});
+	}
+
+	StringList WebUserManager::getModuleWarmupProfile(Session::SessionType aType) const noexcept {
+		auto& settings = wsm->getSettingsManager();
+		switch (aType) {
+			case Session::TYPE_PLAIN:
+			case Session::TYPE_SECURE: return settings.getSettingItem(WebServerSettings::WEB_UI_MODULE_WARMUP).strList();
+			case Session::TYPE_EXTENSION: return settings.getSettingItem(WebServerSettings::EXTENSION_MODULE_WARMUP).strList();
+
+			// Basic auth sessions are mostly used for single HTTP requests
+			default: return StringList();
+		}
+	}
+
+	void WebUserManager::onModuleInitialized(const string& aModule, uint64_t aDurationMicros) noexcept {
+		Lock l(moduleCS);
+		auto& stats = moduleInitStats[aModule];
+		stats.count++;
+		stats.totalMicros += aDurationMicros;
+		stats.maxMicros = std::max(stats.maxMicros, aDurationMicros);
+	}
+
+	WebUserManager::ModuleInitStatsMap WebUserManager::getModuleInitStats() const noexcept {
+		Lock l(moduleCS);
+		return moduleInitStats;
+	}
+
 	SessionPtr WebUserManager::createExtensionSession(const string& aExtensionName) noexcept {
 		auto uuid = generateUUID();
 
@@ -40,6 +40,10 @@ namespace webserver {
 		// Throws on errors, returns nullptr if no Authorization header is present
 		SessionPtr parseHttpSession(const string& aAuthToken, const string& aIp);
 
+		// Returns the existing session for a bearer token, nullptr otherwise (Basic credentials are never checked)
+		// Sessions aren't created and failed attempts aren't counted so the request must still be authenticated with parseHttpSession
+		SessionPtr getExistingHttpSession(const string& aAuthToken) const noexcept;
+
 		// Throws std::domain_error on errors (e.g. invalid password)
 		SessionPtr authenticateSession(const string& aUserName, const string& aPassword, Session::SessionType aType, uint64_t aMaxInactivityMinutes, const string& aIP);
 		SessionPtr authenticateSession(const string& aRefreshToken, Session::SessionType aType, uint64_t aMaxInactivityMinutes, const string& aIP);
@@ -67,6 +71,21 @@ namespace webserver {
 		size_t getUserSessionCount() const noexcept;
 		string createRefreshToken(const WebUserPtr& aUser) noexcept;
 
+		// API modules that are constructed in the task pool after a session of the given type has been created (configured with web server settings)
+		StringList getModuleWarmupProfile(Session::SessionType aType) const noexcept;
+
+		struct ModuleInitStats {
+			uint64_t count = 0;
+			uint64_t totalMicros = 0;
+			uint64_t maxMicros = 0;
+		};
+
+		using ModuleInitStatsMap = std::map<string, ModuleInitStats>;
+
+		// Construction times of API modules (combined for all sessions)
+		void onModuleInitialized(const string& aModule, uint64_t aDurationMicros) noexcept;
+		ModuleInitStatsMap getModuleInitStats() const noexcept;
+
 		WebUserManager(WebUserManager&) = delete;
 		WebUserManager& operator=(WebUserManager&) = delete;
 
@@ -84,6 +103,9 @@ namespace webserver {
 			BEARER,
 		};
 
+		// Strips the auth scheme (and decodes Basic credentials)
+		static AuthType decodeHttpAuthToken(const string& aAuthToken, string& token_) noexcept;
+
 		struct TokenInfo {
 			const string token;
 			const WebUserPtr user;
@@ -102,6 +124,11 @@ namespace webserver {
 		std::map<LocalSessionId, SessionPtr> sessionsLocalId;
 		std::map<string, TokenInfo> refreshTokens;
 
+		mutable CriticalSection moduleCS;
+		ModuleInitStatsMap moduleInitStats;
+
+		void warmUpModules(const SessionPtr& aSession) noexcept;
+
 		void checkExpiredSessions() noexcept;
 		void checkExpiredTokens() noexcept;
 		void removeSession(const SessionPtr& aSession, SessionRemovalReason aReason) noexcept;